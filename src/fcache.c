@@ -20,21 +20,31 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <fcache.h>
 #include <plog.h>
 #include <pio.h>
 
 static const char *cache_dir;
+static pthread_mutex_t cache_dir_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Suffix of the next temporary file, protected by cache_dir_lock. */
+static unsigned int tmp_id;
 
 static const char *get_cache_dir()
 {
 	char *home;
 
+	pthread_mutex_lock(&cache_dir_lock);
+
 	if (!cache_dir) {
 		home = getenv("HOME");
 
@@ -51,6 +61,8 @@ static const char *get_cache_dir()
 		}
 	}
 
+	pthread_mutex_unlock(&cache_dir_lock);
+
 	return cache_dir;
 }
 
@@ -72,7 +84,37 @@ static char *key_to_path(const char *key)
 	return path;
 }
 
-char *fcache_get(const char *key)
+static char *read_file(const char *path, size_t *size)
+{
+	FILE *f;
+	char *content;
+	long n;
+
+	f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+
+	content = NULL;
+
+	if (!fseek(f, 0, SEEK_END) && (n = ftell(f)) >= 0
+	    && !fseek(f, 0, SEEK_SET)) {
+		content = malloc(n + 1);
+
+		if (fread(content, 1, n, f) == (size_t)n) {
+			content[n] = '\0';
+			*size = n;
+		} else {
+			free(content);
+			content = NULL;
+		}
+	}
+
+	fclose(f);
+
+	return content;
+}
+
+char *fcache_get_data(const char *key, size_t *size)
 {
 	char *path, *content;
 
@@ -82,7 +124,7 @@ char *fcache_get(const char *key)
 		return NULL;
 	}
 
-	content = file_get_content(path);
+	content = read_file(path, size);
 
 	if (content)
 		log_debug(_("file cache hit %s"), key);
@@ -94,10 +136,50 @@ char *fcache_get(const char *key)
 	return content;
 }
 
-void fcache_put(const char *key, const char *value)
+char *fcache_get(const char *key)
+{
+	size_t size;
+
+	return fcache_get_data(key, &size);
+}
+
+/*
+ * Creates exclusively a temporary file next to the entry, with the
+ * permissions fopen() would give to the entry.
+ */
+static int create_tmp(const char *path, char **tmp)
+{
+	unsigned int id;
+	int fd;
+
+	*tmp = malloc(strlen(path) + 1 + 3 * sizeof(long) + 1
+		      + 3 * sizeof(int) + strlen(".tmp") + 1);
+	if (!*tmp)
+		return -1;
+
+	do {
+		pthread_mutex_lock(&cache_dir_lock);
+		id = tmp_id++;
+		pthread_mutex_unlock(&cache_dir_lock);
+
+		sprintf(*tmp, "%s.%ld.%u.tmp", path, (long)getpid(), id);
+
+		fd = open(*tmp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+	} while (fd == -1 && errno == EEXIST);
+
+	return fd;
+}
+
+/*
+ * The content is written into a temporary file which then replaces the
+ * entry: other threads reading the entry meanwhile get the previous
+ * content rather than a truncated one.
+ */
+void fcache_put_data(const char *key, const char *value, size_t size)
 {
 	char *path, *dir, *tmp;
 	FILE *f;
+	int fd, failed;
 
 	path = key_to_path(key);
 	if (!path)
@@ -108,19 +190,32 @@ void fcache_put(const char *key, const char *value)
 	mkdirs(dir, 0777);
 	free(tmp);
 
-	f = fopen(path, "w");
+	fd = create_tmp(path, &tmp);
+	f = fd == -1 ? NULL : fdopen(fd, "wb");
 
 	if (f) {
-		fputs(value, f);
+		failed = fwrite(value, 1, size, f) != size;
+		failed |= fclose(f) != 0;
 
-		fclose(f);
+		if (failed || rename(tmp, path)) {
+			log_err(_("Failed to write %s"), path);
+			unlink(tmp);
+		}
 	} else {
 		log_err(_("Failed to open %s"), path);
+		if (fd != -1)
+			close(fd);
 	}
 
+	free(tmp);
 	free(path);
 }
 
+void fcache_put(const char *key, const char *value)
+{
+	fcache_put_data(key, value, strlen(value));
+}
+
 void fcache_cleanup()
 {
 	free((char *)cache_dir);
@@ -20,11 +20,18 @@
 #ifndef _PPASTATS_FCACHE_H_
 #define _PPASTATS_FCACHE_H_
 
-#include <json.h>
+#include <stddef.h>
 
 char *fcache_get(const char *k);
 void fcache_put(const char *k, const char *v);
 
+/*
+ * Returns the content of an entry which can contain null bytes, its
+ * size is stored in 'size'. The content is null-terminated too.
+ */
+char *fcache_get_data(const char *k, size_t *size);
+void fcache_put_data(const char *k, const char *v, size_t size);
+
 void fcache_cleanup();
 
 #endif
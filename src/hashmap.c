@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hashmap.h>
+
+/* Open addressing with linear probing, the capacity is a power of 2. */
+
+struct hashmap_entry {
+	const char *key;
+	unsigned int hash;
+	void *value;
+};
+
+struct hashmap {
+	struct hashmap_entry *entries;
+	int capacity;
+	int size;
+};
+
+static const int INITIAL_CAPACITY = 64;
+
+struct hashmap *hashmap_new()
+{
+	struct hashmap *map;
+
+	map = malloc(sizeof(struct hashmap));
+	map->capacity = INITIAL_CAPACITY;
+	map->size = 0;
+	map->entries = calloc(map->capacity, sizeof(struct hashmap_entry));
+
+	return map;
+}
+
+void hashmap_free(struct hashmap *map)
+{
+	if (map) {
+		free(map->entries);
+		free(map);
+	}
+}
+
+static struct hashmap_entry *
+lookup(struct hashmap_entry *entries, int capacity,
+       const char *key, unsigned int h)
+{
+	struct hashmap_entry *e;
+	int i;
+
+	i = h & (capacity - 1);
+	for (;;) {
+		e = &entries[i];
+
+		if (!e->key || (e->hash == h && !strcmp(e->key, key)))
+			return e;
+
+		i = (i + 1) & (capacity - 1);
+	}
+}
+
+static void grow(struct hashmap *map)
+{
+	struct hashmap_entry *entries, *e, *cur;
+	int capacity, i;
+
+	capacity = 2 * map->capacity;
+	entries = calloc(capacity, sizeof(struct hashmap_entry));
+
+	for (i = 0; i < map->capacity; i++) {
+		cur = &map->entries[i];
+
+		if (cur->key) {
+			e = lookup(entries, capacity, cur->key, cur->hash);
+			*e = *cur;
+		}
+	}
+
+	free(map->entries);
+	map->entries = entries;
+	map->capacity = capacity;
+}
+
+void *hashmap_get(const struct hashmap *map, const char *key)
+{
+	struct hashmap_entry *e;
+
+	e = lookup(map->entries, map->capacity, key, hashmap_hash(key));
+
+	return e->value;
+}
+
+void hashmap_put(struct hashmap *map, const char *key, void *value)
+{
+	struct hashmap_entry *e;
+	unsigned int h;
+
+	/* keeps the load factor under 3/4 */
+	if (4 * (map->size + 1) > 3 * map->capacity)
+		grow(map);
+
+	h = hashmap_hash(key);
+	e = lookup(map->entries, map->capacity, key, h);
+
+	if (!e->key) {
+		e->key = key;
+		e->hash = h;
+		map->size++;
+	}
+	e->value = value;
+}
+
+int hashmap_size(const struct hashmap *map)
+{
+	return map->size;
+}
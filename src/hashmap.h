@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_HASHMAP_H_
+#define _PPASTATS_HASHMAP_H_
+
+/*
+ * Hash table associating strings to pointers.
+ *
+ * Keys are not copied: they must remain valid as long as they are
+ * stored in the map.
+ */
+struct hashmap;
+
+/* FNV-1a hash of 'str', also used by the string pools. */
+static inline unsigned int hashmap_hash(const char *str)
+{
+	unsigned int h;
+
+	h = 2166136261u;
+	while (*str) {
+		h ^= (unsigned char)*str;
+		h *= 16777619u;
+		str++;
+	}
+
+	return h;
+}
+
+struct hashmap *hashmap_new();
+
+void hashmap_free(struct hashmap *map);
+
+/* Returns the value associated to 'key' or NULL. */
+void *hashmap_get(const struct hashmap *map, const char *key);
+
+/*
+ * Associates 'value' to 'key', replacing the previous association if
+ * any. 'value' must not be NULL.
+ */
+void hashmap_put(struct hashmap *map, const char *key, void *value);
+
+int hashmap_size(const struct hashmap *map);
+
+#endif
@@ -20,23 +20,27 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
-#include <json.h>
-
+#include <hashmap.h>
 #include "html.h"
+#include <json_writer.h>
+#include <list.h>
 #include "lp.h"
-#include <lp_json.h>
 #include "lp_ws.h"
 #include "ppastats.h"
 #include <pio.h>
 #include <plog.h>
 #include <pstr.h>
+#include <ptime.h>
 
 static char *css_dir;
 static char *js_dir;
@@ -47,6 +51,8 @@ static char *ppa_body;
 static char *pkg_body;
 static char *pkg_version_body;
 static char *header;
+static char *owner_body;
+static pthread_once_t templates_once = PTHREAD_ONCE_INIT;
 
 void html_set_theme_dir(const char *theme_dir)
 {
@@ -73,130 +79,142 @@ static char *path_new(const char *dir, const char *file, const char *suffixe)
 	return path;
 }
 
+/*
+ * Reads a template, returns NULL if it cannot be read. 'name' is used
+ * in the error message.
+ */
+static char *read_template(const char *file, const char *name)
+{
+	char *path, *tpl;
+
+	path = path_append(tpl_dir, file);
+	tpl = file_get_content(path);
+
+	if (!tpl)
+		log_err("Failed to read %s template: %s", name, path);
+
+	free(path);
+
+	return tpl;
+}
+
+/*
+ * The templates are read once, before their first use, and shared by
+ * the threads generating the pages of several PPAs.
+ */
+static void read_templates()
+{
+	header = read_template("header.tpl", "header");
+	footer = read_template("footer.tpl", "footer");
+	pkg_version_body = read_template("pkg_version.tpl", "package version");
+	ppa_body = read_template("ppa.tpl", "PPA");
+	pkg_body = read_template("pkg.tpl", "package");
+	owner_body = read_template("owner.tpl", "owner");
+}
+
 static char *get_header(const char *title, const char *script)
 {
-	char *res, *tmp, *path;
+	char *res, *tmp;
 
-	if (!header) {
-		path = path_append(tpl_dir, "header.tpl");
-		header = file_get_content(path);
-	} else {
-		path = NULL;
-	}
+	pthread_once(&templates_once, read_templates);
 
-	if (header) {
-		tmp = strdup(header);
-		res = strrep(tmp, "@SCRIPT@", script);
+	if (!header)
+		return NULL;
 
-		if (res != tmp)
-			free(tmp);
+	tmp = strdup(header);
+	res = strrep(tmp, "@SCRIPT@", script);
 
-		tmp = res;
-		res = strrep(tmp, "@TITLE@", title);
+	if (res != tmp)
+		free(tmp);
 
-		if (res != tmp)
-			free(tmp);
-	} else {
-		log_err("Failed to read header template: %s", path);
-		res = NULL;
-	}
+	tmp = res;
+	res = strrep(tmp, "@TITLE@", title);
 
-	free(path);
+	if (res != tmp)
+		free(tmp);
 
 	return res;
 }
 
 static const char *get_footer()
 {
-	char *path;
-
-	if (!footer) {
-		path = path_append(tpl_dir, "footer.tpl");
-		footer = file_get_content(path);
-
-		if (!footer)
-			log_err("Failed to read footer template: %s", path);
-
-		free(path);
-	}
+	pthread_once(&templates_once, read_templates);
 
 	return footer;
 }
 
 static const char *get_pkg_version_body()
 {
-	char *path;
-
-	if (!pkg_version_body) {
-		path = path_append(tpl_dir, "pkg_version.tpl");
-		pkg_version_body = file_get_content(path);
-
-		if (!pkg_version_body)
-			log_err("Failed to read package version template: %s",
-				path);
-
-		free(path);
-	}
+	pthread_once(&templates_once, read_templates);
 
 	return pkg_version_body;
 }
+
 static const char *get_ppa_body()
 {
-	char *path;
-
-	if (!ppa_body) {
-		path = path_append(tpl_dir, "ppa.tpl");
-		ppa_body = file_get_content(path);
-
-		if (!ppa_body)
-			log_err("Failed to read PPA template: %s", path);
-
-		free(path);
-	}
+	pthread_once(&templates_once, read_templates);
 
 	return ppa_body;
 }
 
 static const char *get_pkg_body()
 {
-	char *path;
-
-	if (!pkg_body) {
-		path = path_append(tpl_dir, "pkg.tpl");
-		pkg_body = file_get_content(path);
-
-		if (!pkg_body)
-			log_err("Failed to read package template: %s", path);
-
-		free(path);
-	}
+	pthread_once(&templates_once, read_templates);
 
 	return pkg_body;
 }
 
-static void json_add_ddts(json_object *json,
-			  struct daily_download_total **ddts)
+static const char *get_owner_body()
 {
-	json_object_object_add(json, "ddts", ddts_to_json(ddts));
+	pthread_once(&templates_once, read_templates);
+
+	return owner_body;
 }
 
-static json_object *distro_to_json(struct distro_stats *d)
+static void write_ddts(struct json_writer *w,
+		       struct daily_download_total **ddts)
 {
-	json_object *json;
+	struct daily_download_total *ddt;
+
+	json_write_key(w, "ddts");
+	json_write_array_begin(w);
 
-	json = json_object_new_object();
+	while (ddts && *ddts) {
+		ddt = *ddts;
 
-	json_object_object_add(json,
-			       "name",
-			       json_object_new_string(d->name));
+		json_write_object_begin(w);
 
-	json_object_object_add(json,
-			       "count",
-			       json_object_new_int(d->download_count));
+		json_write_key(w, "value");
+		json_write_int(w, ddt->count);
 
-	json_add_ddts(json, d->ddts);
+		json_write_key(w, "time");
+		json_write_array_begin(w);
+		json_write_int(w, ddt->date.tm_year + 1900);
+		json_write_int(w, ddt->date.tm_mon + 1);
+		json_write_int(w, ddt->date.tm_mday);
+		json_write_array_end(w);
 
-	return json;
+		json_write_object_end(w);
+
+		ddts++;
+	}
+
+	json_write_array_end(w);
+}
+
+static void distro_to_json(struct json_writer *w, struct distro_stats *d)
+{
+	json_write_object_begin(w);
+
+	json_write_key(w, "name");
+	json_write_string(w, d->name);
+
+	json_write_key(w, "count");
+	json_write_int(w, d->download_count);
+
+	write_ddts(w, d->ddts);
+
+	json_write_object_end(w);
 }
 
 static int version_cmp(const void *o1, const void *o2)
@@ -230,205 +248,482 @@ static struct version_stats **sort_versions(struct version_stats **vers)
 	return result;
 }
 
-static json_object *
-pkg_to_json(struct ppa_stats *ppa, struct package_stats *pkg)
+static void write_ppa(struct json_writer *w, struct ppa_stats *ppa)
+{
+	json_write_key(w, "ppa_name");
+	json_write_string(w, ppa->name);
+
+	json_write_key(w, "ppa_owner");
+	json_write_string(w, ppa->owner);
+}
+
+static void
+pkg_to_json(struct json_writer *w,
+	    struct ppa_stats *ppa,
+	    struct package_stats *pkg)
 {
-	json_object *json, *json_versions, *json_distros, *json_distro;
 	struct version_stats **versions, **tmp;
-	struct distro_stats **distros, *d;
+	struct distro_stats **distros;
 
-	json = json_object_new_object();
+	json_write_object_begin(w);
 
-	json_object_object_add(json,
-			       "ppa_name", json_object_new_string(ppa->name));
-	json_object_object_add(json,
-			       "ppa_owner",
-			       json_object_new_string(ppa->owner));
+	write_ppa(w, ppa);
 
-	json_object_object_add(json,
-			       "name", json_object_new_string(pkg->name));
+	json_write_key(w, "name");
+	json_write_string(w, pkg->name);
 
-	json_versions = json_object_new_array();
-	json_object_object_add(json, "versions", json_versions);
+	json_write_key(w, "versions");
+	json_write_array_begin(w);
 	versions = sort_versions(pkg->versions);
 	tmp = versions;
 	while (*tmp) {
-		json_object_array_add
-			(json_versions,
-			 json_object_new_string((*tmp)->version));
-
+		json_write_string(w, (*tmp)->version);
 		tmp++;
 	}
 	free(versions);
+	json_write_array_end(w);
 
 	distros = pkg->distros;
 	if (distros) {
-		json_distros = json_object_new_array();
-		json_object_object_add(json, "distros", json_distros);
+		json_write_key(w, "distros");
+		json_write_array_begin(w);
 
 		while (*distros) {
-			d = *distros;
-
-			if (d->download_count) {
-				json_distro = distro_to_json(d);
-
-				json_object_array_add(json_distros,
-						      json_distro);
-			}
+			if ((*distros)->download_count)
+				distro_to_json(w, *distros);
 
 			distros++;
 		}
+
+		json_write_array_end(w);
 	}
 
-	json_add_ddts(json, pkg->daily_download_totals);
+	write_ddts(w, pkg->daily_download_totals);
 
-	return json;
+	json_write_object_end(w);
 }
 
 static char *version_to_json(struct ppa_stats *ppa,
 			     struct package_stats *pkg,
 			     struct version_stats *ver)
 {
-	char *ret;
-	struct distro_stats **distros, *distro;
-	json_object *json, *json_distros, *json_distro, *json_archs, *json_arch;
+	struct json_writer *w;
+	struct distro_stats **distros;
 	struct arch_stats **archs;
+	char date[ISO8601_TIME_SIZE];
 
-	json = json_object_new_object();
+	w = json_writer_new(JSON_WRITER_SPACED);
 
-	json_object_object_add(json,
-			       "ppa_name", json_object_new_string(ppa->name));
-	json_object_object_add(json,
-			       "ppa_owner",
-			       json_object_new_string(ppa->owner));
+	json_write_object_begin(w);
 
-	json_object_object_add(json,
-			       "pkg_name", json_object_new_string(pkg->name));
+	write_ppa(w, ppa);
 
-	json_object_object_add(json,
-			       "name", json_object_new_string(ver->version));
+	json_write_key(w, "pkg_name");
+	json_write_string(w, pkg->name);
 
-	json_object_object_add(json,
-			       "date_created", time_to_json(ver->date_created));
+	json_write_key(w, "name");
+	json_write_string(w, ver->version);
 
-	json_add_ddts(json, ver->daily_download_totals);
+	json_write_key(w, "date_created");
+	json_write_string(w, time_to_ISO8601_time_r(ver->date_created, date));
 
+	write_ddts(w, ver->daily_download_totals);
+
+	json_write_key(w, "distros");
+	json_write_array_begin(w);
 	distros = ver->distros;
-	json_distros = json_object_new_array();
-	json_object_object_add(json, "distros", json_distros);
 	while (*distros) {
-		distro = *distros;
-		json_distro = json_object_new_object();
-
-		json_object_array_add(json_distros, json_distro);
+		json_write_object_begin(w);
 
-		json_object_object_add(json_distro,
-				       "name",
-				       json_object_new_string(distro->name));
+		json_write_key(w, "name");
+		json_write_string(w, (*distros)->name);
 
-		archs = distro->archs;
-		json_archs = json_object_new_array();
-		json_object_object_add(json_distro, "archs", json_archs);
+		json_write_key(w, "archs");
+		json_write_array_begin(w);
+		archs = (*distros)->archs;
 		while (*archs) {
-			json_arch = json_object_new_object();
+			json_write_object_begin(w);
 
-			json_object_object_add
-				(json_arch,
-				 "name",
-				 json_object_new_string((*archs)->name));
+			json_write_key(w, "name");
+			json_write_string(w, (*archs)->name);
 
-			json_object_object_add
-				(json_arch,
-				 "count",
-				 json_object_new_int((*archs)->download_count));
+			json_write_key(w, "count");
+			json_write_int(w, (*archs)->download_count);
 
-			json_object_array_add(json_archs, json_arch);
+			json_write_object_end(w);
 			archs++;
 		}
+		json_write_array_end(w);
 
+		json_write_object_end(w);
 		distros++;
 	}
+	json_write_array_end(w);
 
-	ret = strdup(json_object_to_json_string(json));
+	json_write_object_end(w);
 
-	json_object_put(json);
-
-	return ret;
+	return json_writer_to_string(w);
 }
 
-static json_object *ppa_to_json(struct ppa_stats *ppa)
+static void ppa_to_json(struct json_writer *w, struct ppa_stats *ppa)
 {
-	json_object *json, *json_pkgs, *json_pkg;
 	struct package_stats **pkgs;
 
-	json = json_object_new_object();
+	json_write_object_begin(w);
 
-	json_object_object_add(json,
-			       "ppa_name", json_object_new_string(ppa->name));
-	json_object_object_add(json,
-			       "ppa_owner",
-			       json_object_new_string(ppa->owner));
+	write_ppa(w, ppa);
 
-	json_add_ddts(json, ppa->daily_download_totals);
+	write_ddts(w, ppa->daily_download_totals);
 
+	json_write_key(w, "packages");
+	json_write_array_begin(w);
 	pkgs = ppa->packages;
-	json_pkgs = json_object_new_array();
-	json_object_object_add(json, "packages", json_pkgs);
-	while (*pkgs) {
-		json_pkg = json_object_new_object();
-		json_object_array_add(json_pkgs, json_pkg);
+	while (pkgs && *pkgs) {
+		json_write_object_begin(w);
 
-		json_object_object_add(json_pkg, "name",
-				       json_object_new_string((*pkgs)->name));
+		json_write_key(w, "name");
+		json_write_string(w, (*pkgs)->name);
 
-		json_object_object_add
-			(json_pkg, "count",
-			 json_object_new_int((*pkgs)->download_count));
+		json_write_key(w, "count");
+		json_write_int(w, (*pkgs)->download_count);
 
+		json_write_object_end(w);
 		pkgs++;
 	}
+	json_write_array_end(w);
+
+	json_write_object_end(w);
+}
+
+/*
+ * Digests of the contents of the written pages, per directory of a PPA
+ * or of an owner. A page whose content did not change since it has
+ * been written by the process is not written again, the daemon
+ * regenerates the pages of a PPA after each refresh but only the
+ * affected ones are rewritten. Each generation of a directory replaces
+ * its digests, so the pages which are not generated anymore are
+ * forgotten.
+ */
+struct page {
+	char *path;
+	uint64_t digest;
+};
+
+struct pages {
+	struct page **pages;
+	struct hashmap *index;
+};
+
+struct page_dir {
+	char *path;
+	/* pages of the last generation, NULL before the first one */
+	struct pages *written;
+};
+
+/*
+ * Generation of the pages of a directory.
+ *
+ * Without memory to track the directory, 'dir' and 'pages' are NULL
+ * and all the pages are written.
+ */
+struct page_gen {
+	struct page_dir *dir;
+	/* pages written or unchanged so far */
+	struct pages *pages;
+};
+
+static struct page_dir **page_dirs;
+static struct hashmap *page_dirs_index;
+static pthread_mutex_t pages_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* 64 bits FNV-1a hash. */
+static uint64_t get_digest(const char *data, size_t len)
+{
+	uint64_t h;
+	size_t i;
+
+	h = 0xcbf29ce484222325ULL;
+	for (i = 0; i < len; i++) {
+		h ^= (unsigned char)data[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+static struct pages *pages_new()
+{
+	struct pages *p;
 
-	return json;
+	p = malloc(sizeof(struct pages));
+	p->pages = NULL;
+	p->index = hashmap_new();
+
+	return p;
+}
+
+static void pages_free(struct pages *p)
+{
+	int i;
+
+	if (!p)
+		return ;
+
+	for (i = 0; i < vector_length((void **)p->pages); i++) {
+		free(p->pages[i]->path);
+		free(p->pages[i]);
+	}
+	vector_free((void **)p->pages);
+	hashmap_free(p->index);
+	free(p);
+}
+
+static void page_gen_begin(struct page_gen *gen, const char *dir)
+{
+	struct page_dir *d, **dirs;
+
+	pthread_mutex_lock(&pages_lock);
+
+	if (!page_dirs_index)
+		page_dirs_index = hashmap_new();
+
+	d = hashmap_get(page_dirs_index, dir);
+	if (!d) {
+		d = malloc(sizeof(struct page_dir));
+		dirs = NULL;
+		if (d)
+			dirs = (struct page_dir **)
+				vector_push((void **)page_dirs, d);
+
+		if (dirs) {
+			page_dirs = dirs;
+			d->path = strdup(dir);
+			d->written = NULL;
+			hashmap_put(page_dirs_index, d->path, d);
+		} else {
+			log_err(_("Failed to keep the pages of %s"), dir);
+			free(d);
+			d = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&pages_lock);
+
+	gen->dir = d;
+	gen->pages = d ? pages_new() : NULL;
+}
+
+/* Replaces the digests of the directory by the ones of the generation. */
+static void page_gen_end(struct page_gen *gen)
+{
+	struct pages *old;
+
+	if (!gen->dir)
+		return ;
+
+	pthread_mutex_lock(&pages_lock);
+	old = gen->dir->written;
+	gen->dir->written = gen->pages;
+	pthread_mutex_unlock(&pages_lock);
+
+	pages_free(old);
+}
+
+static int
+is_page_unchanged(struct page_gen *gen, const char *path, uint64_t digest)
+{
+	struct pages *written;
+	struct page *page;
+	int ret;
+
+	if (!gen->dir)
+		return 0;
+
+	pthread_mutex_lock(&pages_lock);
+	written = gen->dir->written;
+	page = written ? hashmap_get(written->index, path) : NULL;
+	ret = page && page->digest == digest;
+	pthread_mutex_unlock(&pages_lock);
+
+	return ret;
 }
 
+/*
+ * The generation is only used by its thread, it needs no lock.
+ *
+ * A page whose digest cannot be kept is written again next time.
+ */
 static void
-create_html(const char *path,
-	    const char *title,
-	    const char *body_template,
-	    const char *script)
+set_page_digest(struct page_gen *gen, const char *path, uint64_t digest)
 {
-	FILE *f;
-	const char *footer;
-	char *header;
+	struct pages *p;
+	struct page *page, **pages;
 
-	f = NULL;
+	p = gen->pages;
+	if (!p)
+		return ;
 
-	header = get_header(title, script);
-	if (!header) {
-		log_err(_("Failed to get the header template"));
-		goto on_error;
+	page = hashmap_get(p->index, path);
+	if (!page) {
+		page = malloc(sizeof(struct page));
+		if (!page)
+			return ;
+
+		pages = (struct page **)vector_push((void **)p->pages, page);
+		if (!pages) {
+			free(page);
+			return ;
+		}
+
+		p->pages = pages;
+		page->path = strdup(path);
+		hashmap_put(p->index, page->path, page);
 	}
+	page->digest = digest;
+}
 
-	f = fopen(path, "w");
+/* Writes a page unless it has already been written with 'content'. */
+static void write_page(struct page_gen *gen,
+		       const char *path,
+		       const char *content,
+		       size_t len)
+{
+	FILE *f;
+	uint64_t digest;
+	int failure;
 
+	digest = get_digest(content, len);
+	if (is_page_unchanged(gen, path, digest)) {
+		log_debug(_("page unchanged %s"), path);
+		set_page_digest(gen, path, digest);
+		return ;
+	}
+
+	f = fopen(path, "w");
 	if (!f) {
 		log_err(_("Failed to open: %s"), path);
-		goto on_error;
+		return ;
 	}
 
-	fputs(header, f);
-	fputs(body_template, f);
+	failure = fwrite(content, 1, len, f) != len;
+	if (fclose(f))
+		failure = 1;
+
+	if (failure)
+		log_err(_("Failed to write: %s"), path);
+	else
+		set_page_digest(gen, path, digest);
+}
+
+/*
+ * Returns a writer of a JSON page streamed into the temporary file
+ * 'tmp', or NULL if it cannot be created.
+ */
+static struct json_writer *json_page_open(const char *tmp)
+{
+	struct json_writer *w;
+
+	w = json_writer_open(tmp, JSON_WRITER_PLAIN);
+	if (!w)
+		log_err(_("Failed to open: %s"), tmp);
+
+	return w;
+}
+
+/*
+ * Closes the writer of a JSON page, its temporary file 'tmp' replaces
+ * the page unless it has already been written with the same content.
+ */
+static void json_page_close(struct page_gen *gen,
+			    const char *path,
+			    const char *tmp,
+			    struct json_writer *w)
+{
+	uint64_t digest;
+
+	digest = w->digest;
+
+	if (json_writer_close(w)) {
+		log_err(_("Failed to write: %s"), path);
+		unlink(tmp);
+	} else if (is_page_unchanged(gen, path, digest)) {
+		log_debug(_("page unchanged %s"), path);
+		unlink(tmp);
+		set_page_digest(gen, path, digest);
+	} else if (rename(tmp, path)) {
+		log_err(_("Failed to write: %s"), path);
+		unlink(tmp);
+	} else {
+		set_page_digest(gen, path, digest);
+	}
+}
+
+static char *tmp_path_new(const char *path)
+{
+	char *tmp;
+
+	tmp = malloc(strlen(path) + strlen(".tmp") + 1);
+	strcpy(tmp, path);
+	strcat(tmp, ".tmp");
+
+	return tmp;
+}
+
+/* Writes the plain JSON file of a PPA or of one of its packages. */
+static void json_to_file(struct page_gen *gen,
+			 const char *path,
+			 struct ppa_stats *ppa,
+			 struct package_stats *pkg)
+{
+	struct json_writer *w;
+	char *tmp;
+
+	tmp = tmp_path_new(path);
+
+	w = json_page_open(tmp);
+	if (w) {
+		if (pkg)
+			pkg_to_json(w, ppa, pkg);
+		else
+			ppa_to_json(w, ppa);
+
+		json_page_close(gen, path, tmp, w);
+	}
+
+	free(tmp);
+}
+
+static void
+create_html(struct page_gen *gen,
+	    const char *path,
+	    const char *title,
+	    const char *body_template,
+	    const char *script)
+{
+	const char *footer;
+	char *header, *html;
+	size_t len;
+
+	header = get_header(title, script);
+	if (!header) {
+		log_err(_("Failed to get the header template"));
+		return ;
+	}
 
 	footer = get_footer();
-	if (footer)
-		fputs(footer, f);
+	if (!footer)
+		footer = "";
+
+	len = strlen(header) + strlen(body_template) + strlen(footer);
+	html = malloc(len + 1);
+	strcpy(html, header);
+	strcat(html, body_template);
+	strcat(html, footer);
 
- on_error:
-	if (header)
-		free(header);
+	write_page(gen, path, html, len);
 
-	if (f)
-		fclose(f);
+	free(html);
+	free(header);
 }
 
 static char *ppa_display_name(const struct ppa_stats *ppa)
@@ -443,10 +738,9 @@ static char *ppa_display_name(const struct ppa_stats *ppa)
 }
 
 static void
-index_to_html(struct ppa_stats *ppa, const char *dir)
+index_to_html(struct page_gen *gen, struct ppa_stats *ppa, const char *dir)
 {
 	char *path, *json_path, *dname;
-	json_object *json;
 	const char *body;
 
 	body = get_ppa_body();
@@ -455,23 +749,22 @@ index_to_html(struct ppa_stats *ppa, const char *dir)
 		return ;
 	}
 
-	json = ppa_to_json(ppa);
 	json_path = path_new(dir, "index", ".json");
 
 	log_debug(_("generating %s"), json_path);
-	json_object_to_file(json_path, json);
-	json_object_put(json);
+	json_to_file(gen, json_path, ppa, NULL);
 	free(json_path);
 
 	path = path_new(dir, "index", ".html");
 	dname = ppa_display_name(ppa);
-	create_html(path, dname, body, "ppastats_ppa();");
+	create_html(gen, path, dname, body, "ppastats_ppa();");
 	free(path);
 	free(dname);
 }
 
 static void
-version_to_html(struct ppa_stats *ppa,
+version_to_html(struct page_gen *gen,
+		struct ppa_stats *ppa,
 		struct package_stats *pkg,
 		struct version_stats *version,
 		const char *dir)
@@ -502,7 +795,7 @@ version_to_html(struct ppa_stats *ppa,
 	script = malloc(strlen(script_tpl) - 2 + strlen(json) + 1);
 	sprintf(script, script_tpl, json);
 
-	create_html(path, f_name, body, script);
+	create_html(gen, path, f_name, body, script);
 
 	free(script);
 	free(json);
@@ -511,10 +804,12 @@ version_to_html(struct ppa_stats *ppa,
 }
 
 static void
-pkg_to_html(struct ppa_stats *ppa, struct package_stats *pkg, const char *dir)
+pkg_to_html(struct page_gen *gen,
+	    struct ppa_stats *ppa,
+	    struct package_stats *pkg,
+	    const char *dir)
 {
 	char *path, *json_path, *script;
-	json_object *json;
 	const char *body;
 
 	body = get_pkg_body();
@@ -524,11 +819,9 @@ pkg_to_html(struct ppa_stats *ppa, struct package_stats *pkg, const char *dir)
 	}
 
 	json_path = path_new(dir, pkg->name, ".json");
-	json = pkg_to_json(ppa, pkg);
 	log_debug(_("Generating %s"), json_path);
 
-	json_object_to_file(json_path, json);
-	json_object_put(json);
+	json_to_file(gen, json_path, ppa, pkg);
 	free(json_path);
 
 	path = path_new(dir, pkg->name, ".html");
@@ -540,24 +833,25 @@ pkg_to_html(struct ppa_stats *ppa, struct package_stats *pkg, const char *dir)
 
 	log_debug(_("Generating %s"), path);
 
-	create_html(path, pkg->name, body, script);
+	create_html(gen, path, pkg->name, body, script);
 	free(path);
 	free(script);
 }
 
 static void
-pkgs_to_html(struct ppa_stats *ppa,
+pkgs_to_html(struct page_gen *gen,
+	     struct ppa_stats *ppa,
 	     struct package_stats **pkgs,
 	     const char *dir)
 {
 	struct version_stats **versions;
 
-	while (*pkgs) {
-		pkg_to_html(ppa, *pkgs, dir);
+	while (pkgs && *pkgs) {
+		pkg_to_html(gen, ppa, *pkgs, dir);
 
 		versions = (*pkgs)->versions;
-		while (*versions) {
-			version_to_html(ppa, *pkgs, *versions, dir);
+		while (versions && *versions) {
+			version_to_html(gen, ppa, *pkgs, *versions, dir);
 
 			versions++;
 		}
@@ -566,47 +860,147 @@ pkgs_to_html(struct ppa_stats *ppa,
 	}
 }
 
-void
+static void install_static_files(const char *output_dir)
+{
+	char *css_odir, *js_odir;
+
+	css_odir = path_append(output_dir, "css");
+	js_odir = path_append(output_dir, "js");
+
+	dir_rcopy(css_dir, css_odir);
+	dir_rcopy(js_dir, js_odir);
+
+	free(css_odir);
+	free(js_odir);
+}
+
+void ppa_stats_to_html(struct ppa_stats *ppastats,
+		       const char *output_dir,
+		       const int static_files)
+{
+	struct page_gen gen;
+
+	mkdirs(output_dir, 0777);
+
+	if (static_files)
+		install_static_files(output_dir);
+
+	page_gen_begin(&gen, output_dir);
+
+	pkgs_to_html(&gen, ppastats, ppastats->packages, output_dir);
+
+	index_to_html(&gen, ppastats, output_dir);
+
+	page_gen_end(&gen);
+}
+
+int
 ppa_to_html(const char *owner,
 	    const char *ppa,
 	    const char *package_status,
 	    const char *output_dir,
 	    const int install_static_files,
-	    int ws_size)
+	    int ws_size,
+	    int jobs)
 {
 	struct ppa_stats *ppastats;
-	char *path;
-	char *css_odir, *js_odir;
 
-	mkdirs(output_dir, 0777);
+	ppastats = create_ppa_stats(owner, ppa, package_status, ws_size, jobs);
+	if (!ppastats)
+		return -1;
 
-	if (install_static_files) {
-		css_odir = path_append(output_dir, "css");
-		js_odir = path_append(output_dir, "js");
+	ppa_stats_to_html(ppastats, output_dir, install_static_files);
 
-		dir_rcopy(css_dir, css_odir);
-		dir_rcopy(js_dir, js_odir);
+	ppa_stats_free(ppastats);
+
+	return 0;
+}
+
+static void owner_to_json(struct json_writer *w,
+			  const char *owner,
+			  struct ppa_stats **ppas)
+{
+	struct daily_download_total **ddts;
+	struct ppa_stats **cur;
+
+	json_write_object_begin(w);
+
+	json_write_key(w, "owner");
+	json_write_string(w, owner);
+
+	ddts = ppa_stats_sum_ddts(ppas);
+	write_ddts(w, ddts);
+	daily_download_total_list_free(ddts);
 
-		free(css_odir);
-		free(js_odir);
+	json_write_key(w, "ppas");
+	json_write_array_begin(w);
+	for (cur = ppas; *cur; cur++) {
+		json_write_object_begin(w);
+
+		json_write_key(w, "name");
+		json_write_string(w, (*cur)->name);
+
+		json_write_key(w, "count");
+		json_write_int(w, (*cur)->download_count);
+
+		json_write_object_end(w);
 	}
+	json_write_array_end(w);
 
-	ppastats = create_ppa_stats(owner, ppa, package_status, ws_size);
+	json_write_object_end(w);
+}
 
-	path = path_new(output_dir, "ppa", ".html");
+void owner_to_html(const char *owner,
+		   struct ppa_stats **ppas,
+		   const char *output_dir,
+		   const int static_files)
+{
+	struct json_writer *w;
+	struct page_gen gen;
+	char *path, *tmp, *title;
+	const char *body;
 
-	pkgs_to_html(ppastats, ppastats->packages, output_dir);
+	body = get_owner_body();
+	if (!body) {
+		log_err("Failed to create owner page");
+		return ;
+	}
 
-	index_to_html(ppastats, output_dir);
+	mkdirs(output_dir, 0777);
 
-	ppa_stats_free(ppastats);
+	if (static_files)
+		install_static_files(output_dir);
+
+	page_gen_begin(&gen, output_dir);
+
+	path = path_new(output_dir, "index", ".json");
+	log_debug(_("generating %s"), path);
+
+	tmp = tmp_path_new(path);
+	w = json_page_open(tmp);
+	if (w) {
+		owner_to_json(w, owner, ppas);
+		json_page_close(&gen, path, tmp, w);
+	}
+	free(tmp);
+	free(path);
 
+	path = path_new(output_dir, "index", ".html");
+	title = malloc(1 + strlen(owner) + 1);
+	sprintf(title, "~%s", owner);
+	create_html(&gen, path, title, body, "ppastats_owner();");
+	free(title);
 	free(path);
+
+	page_gen_end(&gen);
 }
 
 void html_cleanup()
 {
+	int i;
+
 	free(header);
+	free(owner_body);
 	free(footer);
 	free(ppa_body);
 	free(pkg_body);
@@ -614,4 +1008,14 @@ void html_cleanup()
 	free(js_dir);
 	free(css_dir);
 	free(tpl_dir);
+
+	if (page_dirs_index) {
+		for (i = 0; i < vector_length((void **)page_dirs); i++) {
+			free(page_dirs[i]->path);
+			pages_free(page_dirs[i]->written);
+			free(page_dirs[i]);
+		}
+		vector_free((void **)page_dirs);
+		hashmap_free(page_dirs_index);
+	}
 }
@@ -21,16 +21,36 @@
 #define _PPASTATS_HTML_H_
 
 #include "lp.h"
+#include "ppastats.h"
 
 /*
  * 'ws_size': size of the reply array of the getPublishedBinaries request.
+ * 'jobs': maximum number of threads used to aggregate the statistics.
+ *
+ * Returns 0 or -1 if the statistics of the PPA could not be created.
+ */
+int ppa_to_html(const char *owner,
+		const char *ppa,
+		const char *package_status,
+		const char *output_dir,
+		const int install_static_files,
+		int ws_size,
+		int jobs);
+
+/* Generates the pages of already aggregated statistics. */
+void ppa_stats_to_html(struct ppa_stats *ppastats,
+		       const char *output_dir,
+		       const int install_static_files);
+
+/*
+ * Generates the index page of an owner listing its PPAs, 'ppas' is a
+ * NULL-terminated vector of their statistics. The pages of each PPA
+ * are expected in 'output_dir'/NAME.
  */
-void ppa_to_html(const char *owner,
-		 const char *ppa,
-		 const char *package_status,
-		 const char *output_dir,
-		 const int install_static_files,
-		 int ws_size);
+void owner_to_html(const char *owner,
+		   struct ppa_stats **ppas,
+		   const char *output_dir,
+		   const int install_static_files);
 
 void html_cleanup();
 
@@ -20,6 +20,7 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -28,11 +29,36 @@
 
 #include "fcache.h"
 #include "http.h"
+#include <list.h>
 #include <plog.h>
 
 static const int DEFAULT_FETCH_RETRIES = 10;
 
-static CURL *curl;
+static pthread_once_t curl_once = PTHREAD_ONCE_INIT;
+static int curl_initialized;
+
+/*
+ * The idle CURL handles. A request takes one from the pool and puts it
+ * back once done: the handles, and the connections they keep open,
+ * outlive the threads of the workers which are created for each
+ * retrieval.
+ */
+static CURL **handles;
+static pthread_mutex_t handles_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The handles share the DNS cache, the TLS sessions and the cookies so
+ * the threads, and the PPAs of a batch, resume the sessions opened by
+ * the others.
+ */
+static CURLSH *share;
+static pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+
+/* Maximum number of requests in progress, 0 if unlimited. */
+static int max_requests;
+static int requests;
+static pthread_mutex_t requests_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t requests_cond = PTHREAD_COND_INITIALIZER;
 
 struct ucontent {
 	char *data;
@@ -53,16 +79,105 @@ static size_t cbk_curl(void *buffer, size_t size, size_t nmemb, void *userp)
 	return realsize;
 }
 
-static void init()
+static void share_lock(CURL *curl, curl_lock_data data,
+		       curl_lock_access access, void *userp)
+{
+	pthread_mutex_lock(&share_locks[data]);
+}
+
+static void share_unlock(CURL *curl, curl_lock_data data, void *userp)
 {
+	pthread_mutex_unlock(&share_locks[data]);
+}
+
+static void global_init()
+{
+	int i;
+
+	log_debug(_("initializing CURL"));
+	curl_global_init(CURL_GLOBAL_ALL);
+
+	share = curl_share_init();
+	if (share) {
+		for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+			pthread_mutex_init(&share_locks[i], NULL);
+
+		curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock);
+		curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+		curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(share,
+				  CURLSHOPT_SHARE,
+				  CURL_LOCK_DATA_SSL_SESSION);
+		curl_share_setopt(share,
+				  CURLSHOPT_SHARE,
+				  CURL_LOCK_DATA_COOKIE);
+	}
+
+	curl_initialized = 1;
+}
+
+void http_set_max_requests(int n)
+{
+	max_requests = n;
+}
+
+static void request_begin()
+{
+	pthread_mutex_lock(&requests_lock);
+	while (max_requests > 0 && requests >= max_requests)
+		pthread_cond_wait(&requests_cond, &requests_lock);
+	requests++;
+	pthread_mutex_unlock(&requests_lock);
+}
+
+static void request_end()
+{
+	pthread_mutex_lock(&requests_lock);
+	requests--;
+	pthread_cond_signal(&requests_cond);
+	pthread_mutex_unlock(&requests_lock);
+}
+
+/* Takes an idle handle from the pool, or creates one if none is left. */
+static CURL *handle_get()
+{
+	CURL *curl;
+
+	pthread_once(&curl_once, global_init);
+
+	pthread_mutex_lock(&handles_lock);
+	curl = vector_pop((void **)handles);
+	pthread_mutex_unlock(&handles_lock);
+
 	if (!curl) {
-		log_debug(_("initializing CURL"));
-		curl_global_init(CURL_GLOBAL_ALL);
 		curl = curl_easy_init();
+
+		if (!curl)
+			exit(EXIT_FAILURE);
+
+		if (share)
+			curl_easy_setopt(curl, CURLOPT_SHARE, share);
 	}
 
-	if (!curl)
-		exit(EXIT_FAILURE);
+	return curl;
+}
+
+/*
+ * Puts back a handle into the pool, it is released if the pool cannot
+ * grow.
+ */
+static void handle_put(CURL *curl)
+{
+	CURL **tmp;
+
+	pthread_mutex_lock(&handles_lock);
+	tmp = (CURL **)vector_push((void **)handles, curl);
+	if (tmp)
+		handles = tmp;
+	pthread_mutex_unlock(&handles_lock);
+
+	if (!tmp)
+		curl_easy_cleanup(curl);
 }
 
 static char *fetch_url(const char *url)
@@ -72,10 +187,12 @@ static char *fetch_url(const char *url)
 	long code;
 	int retries;
 	unsigned int s;
+	CURL *curl;
+	CURLcode res;
 
 	log_debug(_("fetch_url(): %s"), url);
 
-	init();
+	curl = handle_get();
 
 	result = NULL;
 
@@ -96,7 +213,11 @@ static char *fetch_url(const char *url)
 	curl_easy_setopt(curl, CURLOPT_TRANSFER_ENCODING, 1);
 #endif
 
-	if (curl_easy_perform(curl) == CURLE_OK) {
+	request_begin();
+	res = curl_easy_perform(curl);
+	request_end();
+
+	if (res == CURLE_OK) {
 		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
 
 		switch (code) {
@@ -129,6 +250,8 @@ static char *fetch_url(const char *url)
 		}
 	}
 
+	handle_put(curl);
+
 	if (!result)
 		free(content->data);
 
@@ -139,10 +262,20 @@ static char *fetch_url(const char *url)
 
 void http_cleanup()
 {
+	CURL *curl;
+
 	log_fct_enter();
 
-	curl_easy_cleanup(curl);
-	curl_global_cleanup();
+	if (curl_initialized) {
+		while ((curl = vector_pop((void **)handles)))
+			curl_easy_cleanup(curl);
+		vector_free((void **)handles);
+		handles = NULL;
+
+		if (share)
+			curl_share_cleanup(share);
+		curl_global_cleanup();
+	}
 
 	log_fct_exit();
 }
@@ -156,8 +289,10 @@ char *get_url_content(const char *url, unsigned int use_cache)
 	if (use_cache)
 		content = fcache_get(url + 7);
 
-	if (!content)
-		content = fetch_url(url);
+	if (content)
+		return content;
+
+	content = fetch_url(url);
 
 	if (use_cache && content)
 		fcache_put(url + 7, content);
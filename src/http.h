@@ -22,6 +22,12 @@
 
 char *get_url_content(const char *url, unsigned int use_cache);
 
+/*
+ * Limits the number of requests in progress over all the threads, the
+ * other ones wait for their turn. 0 for no limit.
+ */
+void http_set_max_requests(int n);
+
 void http_cleanup();
 
 #endif
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <json_writer.h>
+
+static void put(struct json_writer *w, const char *str, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		w->digest ^= (unsigned char)str[i];
+		w->digest *= 0x100000001b3ULL;
+	}
+
+	if (w->file) {
+		fwrite(str, 1, n, w->file);
+		return ;
+	}
+
+	if (w->len + n + 1 > w->size) {
+		while (w->len + n + 1 > w->size)
+			w->size *= 2;
+		w->buf = realloc(w->buf, w->size);
+	}
+
+	memcpy(w->buf + w->len, str, n);
+	w->len += n;
+	w->buf[w->len] = '\0';
+}
+
+static void puts_raw(struct json_writer *w, const char *str)
+{
+	put(w, str, strlen(str));
+}
+
+static struct json_writer *writer_new(FILE *f, int style)
+{
+	struct json_writer *w;
+
+	w = calloc(1, sizeof(struct json_writer));
+	w->file = f;
+	w->style = style;
+	w->digest = 0xcbf29ce484222325ULL;
+
+	return w;
+}
+
+struct json_writer *json_writer_open(const char *path, int style)
+{
+	FILE *f;
+
+	f = fopen(path, "w");
+	if (!f)
+		return NULL;
+
+	return writer_new(f, style);
+}
+
+int json_writer_close(struct json_writer *w)
+{
+	int ret;
+
+	ret = ferror(w->file) ? -1 : 0;
+	if (fclose(w->file))
+		ret = -1;
+
+	free(w);
+
+	return ret;
+}
+
+struct json_writer *json_writer_new(int style)
+{
+	struct json_writer *w;
+
+	w = writer_new(NULL, style);
+	w->size = 256;
+	w->buf = malloc(w->size);
+	w->buf[0] = '\0';
+
+	return w;
+}
+
+char *json_writer_to_string(struct json_writer *w)
+{
+	char *str;
+
+	str = w->buf;
+	free(w);
+
+	return str;
+}
+
+/* Writes the separator which precedes a value or a key. */
+static void begin_value(struct json_writer *w)
+{
+	if (w->after_key) {
+		w->after_key = 0;
+		return ;
+	}
+
+	if (!w->depth)
+		return ;
+
+	if (w->has_value[w->depth - 1])
+		put(w, ",", 1);
+	else
+		w->has_value[w->depth - 1] = 1;
+
+	if (w->style == JSON_WRITER_SPACED)
+		put(w, " ", 1);
+}
+
+static void begin_container(struct json_writer *w, const char *c)
+{
+	begin_value(w);
+	put(w, c, 1);
+
+	w->has_value[w->depth] = 0;
+	w->depth++;
+}
+
+static void end_container(struct json_writer *w, const char *c)
+{
+	w->depth--;
+
+	if (w->style == JSON_WRITER_SPACED)
+		put(w, " ", 1);
+	put(w, c, 1);
+}
+
+void json_write_object_begin(struct json_writer *w)
+{
+	begin_container(w, "{");
+}
+
+void json_write_object_end(struct json_writer *w)
+{
+	end_container(w, "}");
+}
+
+void json_write_array_begin(struct json_writer *w)
+{
+	begin_container(w, "[");
+}
+
+void json_write_array_end(struct json_writer *w)
+{
+	end_container(w, "]");
+}
+
+/* Escapes the same characters as json-c, including '/'. */
+static void write_escaped(struct json_writer *w, const char *str)
+{
+	static const char *hex = "0123456789abcdef";
+	const char *start;
+	char esc[6];
+	unsigned char c;
+
+	put(w, "\"", 1);
+
+	start = str;
+	while ((c = (unsigned char)*str)) {
+		if (c >= ' ' && c != '"' && c != '\\' && c != '/') {
+			str++;
+			continue;
+		}
+
+		put(w, start, str - start);
+
+		switch (c) {
+		case '\b':
+			puts_raw(w, "\\b");
+			break;
+		case '\n':
+			puts_raw(w, "\\n");
+			break;
+		case '\r':
+			puts_raw(w, "\\r");
+			break;
+		case '\t':
+			puts_raw(w, "\\t");
+			break;
+		case '\f':
+			puts_raw(w, "\\f");
+			break;
+		case '"':
+			puts_raw(w, "\\\"");
+			break;
+		case '\\':
+			puts_raw(w, "\\\\");
+			break;
+		case '/':
+			puts_raw(w, "\\/");
+			break;
+		default:
+			memcpy(esc, "\\u00", 4);
+			esc[4] = hex[c >> 4];
+			esc[5] = hex[c & 0xf];
+			put(w, esc, 6);
+		}
+
+		str++;
+		start = str;
+	}
+
+	put(w, start, str - start);
+	put(w, "\"", 1);
+}
+
+void json_write_key(struct json_writer *w, const char *key)
+{
+	begin_value(w);
+	write_escaped(w, key);
+
+	if (w->style == JSON_WRITER_SPACED)
+		put(w, ": ", 2);
+	else
+		put(w, ":", 1);
+
+	w->after_key = 1;
+}
+
+void json_write_string(struct json_writer *w, const char *str)
+{
+	if (!str) {
+		json_write_null(w);
+		return ;
+	}
+
+	begin_value(w);
+	write_escaped(w, str);
+}
+
+void json_write_int(struct json_writer *w, int i)
+{
+	char str[12];
+
+	begin_value(w);
+	put(w, str, sprintf(str, "%d", i));
+}
+
+void json_write_long(struct json_writer *w, long l)
+{
+	char str[21];
+
+	begin_value(w);
+	put(w, str, sprintf(str, "%ld", l));
+}
+
+void json_write_null(struct json_writer *w)
+{
+	begin_value(w);
+	put(w, "null", 4);
+}
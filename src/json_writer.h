@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_JSON_WRITER_H_
+#define _PPASTATS_JSON_WRITER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Streaming JSON writer.
+ *
+ * Values are written as soon as they are given, without building a
+ * tree, either to a buffered file or to a growable string. The text
+ * is the one produced by json-c with the same formatting style.
+ */
+
+/* No whitespace, like JSON_C_TO_STRING_PLAIN. */
+#define JSON_WRITER_PLAIN 0
+/* A space around the values, like JSON_C_TO_STRING_SPACED. */
+#define JSON_WRITER_SPACED 1
+
+/* maximum number of nested containers */
+#define JSON_WRITER_MAX_DEPTH 32
+
+struct json_writer {
+	FILE *file;
+
+	char *buf;
+	size_t len;
+	size_t size;
+
+	int style;
+
+	int depth;
+	/* whether the container of each depth already has a value */
+	char has_value[JSON_WRITER_MAX_DEPTH];
+	/* whether a key is waiting for its value */
+	int after_key;
+
+	/* 64 bits FNV-1a hash of the text written so far */
+	uint64_t digest;
+};
+
+/* Returns a writer to a file, NULL if it cannot be created. */
+struct json_writer *json_writer_open(const char *path, int style);
+
+/* Closes a file writer, returns 0 on success or -1 on write error. */
+int json_writer_close(struct json_writer *w);
+
+/* Returns a writer to a string. */
+struct json_writer *json_writer_new(int style);
+
+/* Frees a string writer and returns the written text. */
+char *json_writer_to_string(struct json_writer *w);
+
+void json_write_object_begin(struct json_writer *w);
+void json_write_object_end(struct json_writer *w);
+
+void json_write_array_begin(struct json_writer *w);
+void json_write_array_end(struct json_writer *w);
+
+/* Writes the key of the next member of the current object. */
+void json_write_key(struct json_writer *w, const char *key);
+
+/* Writes a string, or null if 'str' is NULL. */
+void json_write_string(struct json_writer *w, const char *str);
+
+void json_write_int(struct json_writer *w, int i);
+void json_write_long(struct json_writer *w, long l);
+
+void json_write_null(struct json_writer *w);
+
+#endif
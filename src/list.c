@@ -17,8 +17,8 @@
   02110-1301 USA
 */
 
+#include <stddef.h>
 #include <stdlib.h>
-#include <string.h>
 
 #include <list.h>
 
@@ -38,41 +38,125 @@ int list_length(void **list)
 	return n;
 }
 
-void **list_add(void **list, void *new_item)
+struct vector {
+	int length;
+	int capacity;
+
+	/* 'capacity' + 1 slots for the NULL terminator */
+	void *items[];
+};
+
+static struct vector *to_vector(void **items)
 {
-	int n;
-	void **new_list;
+	return (struct vector *)
+		((char *)items - offsetof(struct vector, items));
+}
+
+/* Returns NULL on failure, 'v' is then left unchanged. */
+static struct vector *vector_alloc(struct vector *v, int capacity)
+{
+	struct vector *new;
+
+	new = realloc(v,
+		      sizeof(struct vector) + (capacity + 1) * sizeof(void *));
+	if (!new)
+		return NULL;
+
+	new->capacity = capacity;
+
+	return new;
+}
 
-	n = list_length(list);
+void **vector_new(int capacity)
+{
+	struct vector *v;
 
-	new_list = malloc(sizeof(void *)*(n+2));
+	if (capacity < 1)
+		capacity = 1;
 
-	if (n)
-		memcpy(new_list, list, sizeof(void *)*n);
+	v = vector_alloc(NULL, capacity);
+	if (!v)
+		return NULL;
 
-	new_list[n] = new_item;
-	new_list[n+1] = NULL;
+	v->length = 0;
+	v->items[0] = NULL;
 
-	return new_list;
+	return v->items;
 }
 
-void **list_append_list(void **list1, void **list2)
+void **vector_push(void **vector, void *item)
 {
-	int n1, n2, n;
-	void **list;
+	struct vector *v;
 
-	n1 = list_length(list1);
-	n2 = list_length(list2);
+	if (!vector) {
+		vector = vector_new(4);
+		if (!vector)
+			return NULL;
+	}
 
-	n = n1 + n2 + 1;
+	v = to_vector(vector);
+
+	if (v->length == v->capacity) {
+		v = vector_alloc(v, 2 * v->capacity);
+		if (!v)
+			return NULL;
+	}
 
-	list = malloc(sizeof(void *)*(n+1));
+	v->items[v->length] = item;
+	v->length++;
+	v->items[v->length] = NULL;
+
+	return v->items;
+}
+
+void *vector_pop(void **vector)
+{
+	struct vector *v;
+	void *item;
 
-	memcpy(list, list1, n1*sizeof(void *));
-	memcpy(list+n1, list2, n2*sizeof(void *));
+	if (!vector)
+		return NULL;
 
-	list[n1+n2] = NULL;
+	v = to_vector(vector);
 
-	return list;
+	if (!v->length)
+		return NULL;
+
+	v->length--;
+	item = v->items[v->length];
+	v->items[v->length] = NULL;
+
+	return item;
 }
 
+void **vector_shrink(void **vector)
+{
+	struct vector *v, *shrunk;
+
+	if (!vector)
+		return NULL;
+
+	v = to_vector(vector);
+
+	if (v->length && v->length < v->capacity) {
+		shrunk = vector_alloc(v, v->length);
+		if (shrunk)
+			v = shrunk;
+	}
+
+	return v->items;
+}
+
+int vector_length(void **vector)
+{
+	if (!vector)
+		return 0;
+
+	return to_vector(vector)->length;
+}
+
+void vector_free(void **vector)
+{
+	if (vector)
+		free(to_vector(vector));
+}
@@ -29,17 +29,45 @@
 int list_length(void **list);
 
 /*
- * Adds item into a list.
+ * Vector: growable null-terminated list of pointers.
  *
- * Returns a new allocated list containing all items.
+ * The length and the capacity are stored in front of the items so a
+ * vector can be used wherever a null-terminated list is expected. It
+ * must be released with vector_free() and never with free().
+ *
+ * NULL is a valid empty vector.
+ */
+
+/*
+ * Returns a new empty vector able to hold 'capacity' items or NULL if
+ * it cannot be allocated.
  */
-void **list_add(void **list, void *new_item);
+void **vector_new(int capacity);
 
 /*
- * Appends all items of two lists.
+ * Appends an item, the capacity is doubled when it is exhausted.
  *
- * Returns a new allocated list containing all items.
+ * Returns the vector which may have been moved, or NULL if it cannot
+ * grow. The vector is then left unchanged and still owned by the
+ * caller.
  */
-void **list_append_list(void **list1, void **list2);
+void **vector_push(void **vector, void *item);
+
+/* Removes the last item and returns it, or NULL if the vector is empty. */
+void *vector_pop(void **vector);
+
+/*
+ * Reduces the capacity of the vector to its length, the vector is kept
+ * as is if it cannot be reallocated.
+ *
+ * Returns the vector which may have been moved.
+ */
+void **vector_shrink(void **vector);
+
+/* Returns the number of items in the vector, in constant time. */
+int vector_length(void **vector);
+
+/* Frees the vector but not its items. */
+void vector_free(void **vector);
 
 #endif
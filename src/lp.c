@@ -54,55 +54,216 @@ void distro_series_free(struct distro_series *d)
 	}
 }
 
-void bpph_free(struct bpph *b)
-{
-	if (b) {
-		free(b->binary_package_name);
-		free(b->binary_package_version);
-		free(b->distro_arch_series_link);
-		free(b->self_link);
-		free(b->status);
-		free(b);
+struct bpph_table *bpph_table_new()
+{
+	struct bpph_table *t;
+
+	t = malloc(sizeof(struct bpph_table));
+
+	t->length = 0;
+	t->capacity = 0;
+
+	t->self_links = strpool_new();
+	t->strings = strpool_new();
+
+	t->binary_package_name = NULL;
+	t->binary_package_version = NULL;
+	t->distro_arch_series_link = NULL;
+	t->status = NULL;
+	t->architecture_specific = NULL;
+	t->date_created = NULL;
+	t->date_superseded = NULL;
+	t->date_removed = NULL;
+
+	return t;
+}
+
+void bpph_table_free(struct bpph_table *t)
+{
+	if (t) {
+		strpool_free(t->self_links);
+		strpool_free(t->strings);
+
+		free(t->binary_package_name);
+		free(t->binary_package_version);
+		free(t->distro_arch_series_link);
+		free(t->status);
+		free(t->architecture_specific);
+		free(t->date_created);
+		free(t->date_superseded);
+		free(t->date_removed);
+
+		free(t);
 	}
 }
 
-struct bpph *bpph_new(const char *binary_package_name,
-		      const char *binary_package_version,
-		      const char *distro_arch_series_link,
-		      const char *self_link,
-		      const char *status,
-		      int architecture_specific,
-		      time_t date_created)
+static void bpph_table_resize(struct bpph_table *t, int n)
+{
+	t->binary_package_name = realloc(t->binary_package_name,
+					 n * sizeof(int));
+	t->binary_package_version = realloc(t->binary_package_version,
+					    n * sizeof(int));
+	t->distro_arch_series_link = realloc(t->distro_arch_series_link,
+					     n * sizeof(int));
+	t->status = realloc(t->status, n * sizeof(int));
+	t->architecture_specific = realloc(t->architecture_specific, n);
+	t->date_created = realloc(t->date_created, n * sizeof(time_t));
+	t->date_superseded = realloc(t->date_superseded, n * sizeof(time_t));
+	t->date_removed = realloc(t->date_removed, n * sizeof(time_t));
+
+	t->capacity = n;
+}
+
+void bpph_table_reserve(struct bpph_table *t, int n)
 {
-	struct bpph *h;
+	if (n > t->capacity)
+		bpph_table_resize(t, n);
+}
 
-	h = malloc(sizeof(struct bpph));
+int bpph_table_add(struct bpph_table *t,
+		   const char *binary_package_name,
+		   const char *binary_package_version,
+		   const char *distro_arch_series_link,
+		   const char *self_link,
+		   const char *status,
+		   int architecture_specific,
+		   time_t date_created,
+		   time_t date_superseded,
+		   time_t date_removed)
+{
+	int i;
 
-	h->binary_package_name = strdup(binary_package_name);
-	h->binary_package_version = strdup(binary_package_version);
-	h->distro_arch_series_link = strdup(distro_arch_series_link);
-	h->self_link = strdup(self_link);
-	h->architecture_specific = architecture_specific;
-	h->status = strdup(status);
-	h->date_created = date_created;
+	i = strpool_find(t->self_links, self_link);
+	if (i != -1) {
+		t->status[i] = strpool_add(t->strings, status);
+		t->date_superseded[i] = date_superseded;
+		t->date_removed[i] = date_removed;
+		return -1;
+	}
 
-	return h;
+	if (t->length == t->capacity)
+		bpph_table_resize(t, t->capacity ? 2 * t->capacity : 64);
+
+	i = t->length;
+
+	strpool_add(t->self_links, self_link);
+	t->binary_package_name[i] = strpool_add(t->strings,
+						binary_package_name);
+	t->binary_package_version[i] = strpool_add(t->strings,
+						   binary_package_version);
+	t->distro_arch_series_link[i] = strpool_add(t->strings,
+						    distro_arch_series_link);
+	t->status[i] = strpool_add(t->strings, status);
+	t->architecture_specific[i] = architecture_specific;
+	t->date_created[i] = date_created;
+	t->date_superseded[i] = date_superseded;
+	t->date_removed[i] = date_removed;
+
+	t->length++;
+
+	return i;
 }
 
-void bpph_list_free(struct bpph **list)
+int bpph_table_add_row(struct bpph_table *t,
+		       const struct bpph_table *src,
+		       int i)
 {
-	struct bpph **cur;
+	return bpph_table_add(t,
+			      bpph_get_name(src, i),
+			      bpph_get_version(src, i),
+			      bpph_get_distro_arch_series_link(src, i),
+			      bpph_get_self_link(src, i),
+			      bpph_get_status(src, i),
+			      src->architecture_specific[i],
+			      src->date_created[i],
+			      src->date_superseded[i],
+			      src->date_removed[i]);
+}
 
-	if (list) {
-		cur = list;
+int bpph_table_add_table(struct bpph_table *t, const struct bpph_table *src)
+{
+	int i, n;
 
-		while (*cur) {
-			bpph_free(*cur);
-			cur++;
-		}
+	n = t->length;
 
-		free(list);
-	}
+	for (i = 0; i < src->length; i++)
+		bpph_table_add_row(t, src, i);
+
+	return t->length - n;
+}
+
+struct bpph_table *
+bpph_table_slice(const struct bpph_table *t, int start, int n)
+{
+	struct bpph_table *slice;
+	int i;
+
+	slice = bpph_table_new();
+
+	for (i = start; i < start + n; i++)
+		bpph_table_add_row(slice, t, i);
+
+	return slice;
+}
+
+struct bpph_table *bpph_table_filter(const struct bpph_table *t,
+				     int start,
+				     int n,
+				     const char *status)
+{
+	struct bpph_table *rows;
+	int i;
+
+	rows = bpph_table_new();
+
+	for (i = start; i < start + n; i++)
+		if (!status || !strcmp(bpph_get_status(t, i), status))
+			bpph_table_add_row(rows, t, i);
+
+	return rows;
+}
+
+const char *bpph_get_name(const struct bpph_table *t, int i)
+{
+	return strpool_get(t->strings, t->binary_package_name[i]);
+}
+
+const char *bpph_get_version(const struct bpph_table *t, int i)
+{
+	return strpool_get(t->strings, t->binary_package_version[i]);
+}
+
+const char *bpph_get_distro_arch_series_link(const struct bpph_table *t,
+					     int i)
+{
+	return strpool_get(t->strings, t->distro_arch_series_link[i]);
+}
+
+const char *bpph_get_self_link(const struct bpph_table *t, int i)
+{
+	return strpool_get(t->self_links, i);
+}
+
+const char *bpph_get_status(const struct bpph_table *t, int i)
+{
+	return strpool_get(t->strings, t->status[i]);
+}
+
+time_t bpph_get_date_frozen(const struct bpph_table *t, int i)
+{
+	const char *status;
+
+	if (t->date_removed[i] > 0)
+		return t->date_removed[i];
+
+	status = bpph_get_status(t, i);
+
+	if (!strcmp(status, "Superseded")
+	    || !strcmp(status, "Deleted")
+	    || !strcmp(status, "Obsolete"))
+		return t->date_superseded[i] > 0 ? t->date_superseded[i] : 0;
+
+	return 0;
 }
 
 char *get_archive_url(const char *owner, const char *ppa)
@@ -123,6 +284,22 @@ char *get_archive_url(const char *owner, const char *ppa)
 	return url;
 }
 
+char *get_ppas_url(const char *owner)
+{
+	char *url = malloc(strlen(URL_BASE_LP)
+			   +strlen("/~")
+			   +strlen(owner)
+			   +strlen("/ppas")
+			   +1);
+
+	strcpy(url, URL_BASE_LP);
+	strcat(url, "/~");
+	strcat(url, owner);
+	strcat(url, "/ppas");
+
+	return url;
+}
+
 struct distro_arch_series *distro_arch_series_new(const char *display_name,
 						  const char *title,
 						  const char *architecture_tag,
@@ -166,50 +343,123 @@ void distro_arch_series_list_free(struct distro_arch_series **list)
 	}
 }
 
-void daily_download_total_list_free(struct daily_download_total **list)
+struct distro_snapshot *distro_snapshot_new(time_t date)
 {
-	if (list) {
-		struct daily_download_total **cur = list;
+	struct distro_snapshot *s;
+
+	s = malloc(sizeof(struct distro_snapshot));
+	if (!s)
+		return NULL;
+
+	s->date = date;
+	s->arch_series_urls = (char **)vector_new(0);
+	s->arch_series = (struct distro_arch_series **)vector_new(0);
+	s->series_urls = (char **)vector_new(0);
+	s->series = (struct distro_series **)vector_new(0);
+
+	if (!s->arch_series_urls || !s->arch_series
+	    || !s->series_urls || !s->series) {
+		vector_free((void **)s->arch_series_urls);
+		vector_free((void **)s->arch_series);
+		vector_free((void **)s->series_urls);
+		vector_free((void **)s->series);
+		free(s);
+		return NULL;
+	}
 
-		while (*cur) {
-			free(*cur);
-			cur++;
-		}
+	return s;
+}
 
-		free(list);
+/*
+ * Appends a copy of 'url' to '*urls' and 'object' to '*objects', or
+ * nothing if one of them cannot grow.
+ */
+static int
+add_url_object(char ***urls, const char *url, void ***objects, void *object)
+{
+	char *copy, **new_urls;
+	void **new_objects;
+
+	copy = strdup(url);
+	if (!copy)
+		return -1;
+
+	new_urls = (char **)vector_push((void **)*urls, copy);
+	if (!new_urls) {
+		free(copy);
+		return -1;
+	}
+	*urls = new_urls;
+
+	new_objects = vector_push(*objects, object);
+	if (!new_objects) {
+		free(vector_pop((void **)*urls));
+		return -1;
 	}
+	*objects = new_objects;
+
+	return 0;
+}
+
+int distro_snapshot_add_arch_series(struct distro_snapshot *s,
+				    const char *url,
+				    struct distro_arch_series *d)
+{
+	return add_url_object(&s->arch_series_urls,
+			      url,
+			      (void ***)&s->arch_series,
+			      d);
 }
 
-struct bpph **bpph_list_add(struct bpph **list, struct bpph *new)
+int distro_snapshot_add_series(struct distro_snapshot *s,
+			       const char *url,
+			       struct distro_series *d)
 {
-	struct bpph **cur, *bpph, **result;
+	return add_url_object(&s->series_urls,
+			      url,
+			      (void ***)&s->series,
+			      d);
+}
 
-	if (list)
-		for (cur = list; *cur; cur++) {
-			bpph = *cur;
+void distro_snapshot_free(struct distro_snapshot *s, int free_objects)
+{
+	int i;
 
-			if (!strcmp(bpph->self_link, new->self_link))
-				return list;
-		}
+	if (!s)
+		return ;
 
-	result = (struct bpph **)list_add((void **)list, new);
+	for (i = 0; s->arch_series_urls[i]; i++) {
+		free(s->arch_series_urls[i]);
+		if (free_objects)
+			distro_arch_series_free(s->arch_series[i]);
+	}
+
+	for (i = 0; s->series_urls[i]; i++) {
+		free(s->series_urls[i]);
+		if (free_objects)
+			distro_series_free(s->series[i]);
+	}
 
-	free(list);
+	vector_free((void **)s->arch_series_urls);
+	vector_free((void **)s->arch_series);
+	vector_free((void **)s->series_urls);
+	vector_free((void **)s->series);
 
-	return result;
+	free(s);
 }
 
-struct bpph **bpph_list_append_list(struct bpph **list1, struct bpph **list2)
+void daily_download_total_list_free(struct daily_download_total **list)
 {
-	struct bpph **cur;
-
-	if (!list2)
-		return list1;
+	if (list) {
+		struct daily_download_total **cur = list;
 
-	for (cur = list2; *cur; cur++)
-		list1 = bpph_list_add(list1, *cur);
+		while (*cur) {
+			free(*cur);
+			cur++;
+		}
 
-	return list1;
+		vector_free((void **)list);
+	}
 }
 
 time_t ddts_get_last_date(struct daily_download_total **ddts)
@@ -222,7 +472,7 @@ time_t ddts_get_last_date(struct daily_download_total **ddts)
 
 	last_t = 0;
 	for (cur = ddts; *cur; cur++) {
-		t = mktime(&(*cur)->date);
+		t = tm_to_utc_time(&(*cur)->date);
 		if (t > last_t)
 			last_t = t;
 	}
@@ -260,28 +510,30 @@ struct daily_download_total **
 ddts_clone(struct daily_download_total **ddts)
 {
 	int n, i;
-	struct daily_download_total **new;
+	void **new;
 
 	n = ddts_length(ddts);
 
-	new = malloc((n + 1) * sizeof(struct daily_download_total *));
+	new = vector_new(n);
+	if (!new)
+		return NULL;
 
+	/* the capacity is reserved, the vector does not grow */
 	for (i = 0; i < n; i++)
-		new[i] = ddt_clone(ddts[i]);
-
-	new[n] = NULL;
+		new = vector_push(new, ddt_clone(ddts[i]));
 
-	return new;
+	return (struct daily_download_total **)new;
 }
 
 /*
-  Return a newly allocated list with an additional ddt.
-  All ddts are cloned.
+  Add a clone of a ddt into a vector of ddts or update the count of
+  the ddt of the same day. Returns NULL if the vector cannot grow, it
+  is then left unchanged.
  */
 static struct daily_download_total **add_ddt
 (struct daily_download_total **totals, struct daily_download_total *total)
 {
-	struct daily_download_total **cur, **ddts, **result;
+	struct daily_download_total **cur, **result;
 	struct daily_download_total *item;
 
 	if (totals) {
@@ -300,12 +552,11 @@ static struct daily_download_total **add_ddt
 		}
 	}
 
-	ddts = ddts_clone(totals);
-
+	item = ddt_clone(total);
 	result = (struct daily_download_total **)
-		list_add((void **)ddts, ddt_clone((void *)total));
-
-	free(ddts);
+		vector_push((void **)totals, item);
+	if (!result)
+		free(item);
 
 	return result;
 }
@@ -314,22 +565,20 @@ struct daily_download_total **
 ddts_merge(struct daily_download_total **ddts1,
 	   struct daily_download_total **ddts2)
 {
-	struct daily_download_total **ddts, **cur, **tmp;
+	struct daily_download_total **ddts, **cur, **merged;
 
-	if (ddts1) {
-		ddts = ddts_clone(ddts1);
-	} else {
-		ddts = malloc(sizeof(struct daily_download_total *));
-		ddts[0] = NULL;
-	}
+	ddts = ddts_clone(ddts1);
+	if (!ddts)
+		return NULL;
 
 	if (ddts2)
 		for (cur = ddts2; *cur; cur++) {
-			tmp = add_ddt(ddts, *cur);
-			if (tmp != ddts) {
+			merged = add_ddt(ddts, *cur);
+			if (!merged) {
 				daily_download_total_list_free(ddts);
-				ddts = tmp;
+				return NULL;
 			}
+			ddts = merged;
 		}
 
 	return ddts;
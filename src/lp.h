@@ -24,22 +24,50 @@
 
 #include <time.h>
 
+#include <strpool.h>
+
 struct daily_download_total {
 	int count;
 
 	struct tm date;
 };
 
-/* (b)inary (p)ackage (p)ublishing (h)istory */
-struct bpph {
-	char *binary_package_name;
-	char *binary_package_version;
-	char *distro_arch_series_link;
-	char *self_link;
-	char *status;
-	int architecture_specific;
+/* Retrieval state of the daily download totals of a binary. */
+struct ddts_state {
+	/* day number up to which the totals are final, 0 if none */
+	long finalized;
+	/* time of the last retrieval */
+	time_t refreshed;
+	/* delay in seconds before the next retrieval is due */
+	int interval;
+	/* number of downloads during the last 30 days */
+	int velocity;
+};
 
-	time_t date_created;
+/*
+ * Table of (b)inary (p)ackage (p)ublishing (h)istory entries, stored
+ * by columns.
+ *
+ * String columns hold ids of interned strings. The self_link of the
+ * row 'i' is the string 'i' of the 'self_links' pool which makes the
+ * rows unique by self_link.
+ */
+struct bpph_table {
+	int length;
+	int capacity;
+
+	struct strpool *self_links;
+	struct strpool *strings;
+
+	int *binary_package_name;
+	int *binary_package_version;
+	int *distro_arch_series_link;
+	int *status;
+	char *architecture_specific;
+	time_t *date_created;
+	/* 0 if the entry has not been superseded or removed */
+	time_t *date_superseded;
+	time_t *date_removed;
 };
 
 struct distro_arch_series {
@@ -75,24 +103,117 @@ distro_arch_series_new(const char *display_name,
 
 void distro_arch_series_free(struct distro_arch_series *);
 
-void bpph_free(struct bpph *b);
+/*
+ * Snapshot of the distro_series and distro_arch_series, which almost
+ * never change, with their URLs.
+ */
+struct distro_snapshot {
+	/* time of the retrieval of its objects */
+	time_t date;
+	/* vectors, the URL of an object has the same index */
+	char **arch_series_urls;
+	struct distro_arch_series **arch_series;
+	char **series_urls;
+	struct distro_series **series;
+};
+
+/* Returns NULL if the snapshot cannot be allocated. */
+struct distro_snapshot *distro_snapshot_new(time_t date);
+
+/*
+ * Adds an object and a copy of its URL. Returns -1 if they cannot be
+ * added, the snapshot is then unchanged and the object is not owned by
+ * it.
+ */
+int distro_snapshot_add_arch_series(struct distro_snapshot *s,
+				    const char *url,
+				    struct distro_arch_series *d);
+int distro_snapshot_add_series(struct distro_snapshot *s,
+			       const char *url,
+			       struct distro_series *d);
+
+/* Frees the snapshot and its URLs, and its objects if 'free_objects'. */
+void distro_snapshot_free(struct distro_snapshot *s, int free_objects);
+
+struct bpph_table *bpph_table_new();
+
+void bpph_table_free(struct bpph_table *table);
+
+/* Ensures the columns can hold 'n' rows without reallocation. */
+void bpph_table_reserve(struct bpph_table *table, int n);
+
+/*
+ * Appends an entry.
+ *
+ * Returns its row or -1 if the table already contains an entry of the
+ * same self_link. In that case, the status and the dates of removal of
+ * the existing entry are updated with the given ones.
+ */
+int bpph_table_add(struct bpph_table *table,
+		   const char *binary_package_name,
+		   const char *binary_package_version,
+		   const char *distro_arch_series_link,
+		   const char *self_link,
+		   const char *status,
+		   int architecture_specific,
+		   time_t date_created,
+		   time_t date_superseded,
+		   time_t date_removed);
 
-struct bpph *bpph_new(const char *binary_package_name,
-		      const char *binary_package_version,
-		      const char *distro_arch_series_link,
-		      const char *self_link,
-		      const char *status,
-		      int architecture_specific,
-		      time_t date_created);
+/*
+ * Appends the row 'i' of 'src' like bpph_table_add().
+ *
+ * Returns the index of the new row, or -1 if it was already in 'table'.
+ */
+int bpph_table_add_row(struct bpph_table *table,
+		       const struct bpph_table *src,
+		       int i);
 
-void bpph_list_free(struct bpph **list);
+/*
+ * Appends the entries of 'src' which are not already in 'table' and
+ * updates the status of the others.
+ *
+ * Returns the number of added entries, they are the last rows of
+ * 'table'.
+ */
+int bpph_table_add_table(struct bpph_table *table,
+			 const struct bpph_table *src);
 
-struct bpph **bpph_list_append_list(struct bpph **list1, struct bpph **list2);
+/* Returns a new table containing 'n' rows of 'table' from 'start'. */
+struct bpph_table *
+bpph_table_slice(const struct bpph_table *table, int start, int n);
+
+/*
+ * Returns a new table containing the rows of status 'status' among the
+ * 'n' rows of 'table' from 'start', all of them if 'status' is NULL.
+ */
+struct bpph_table *bpph_table_filter(const struct bpph_table *table,
+				     int start,
+				     int n,
+				     const char *status);
+
+const char *bpph_get_name(const struct bpph_table *table, int i);
+const char *bpph_get_version(const struct bpph_table *table, int i);
+const char *bpph_get_distro_arch_series_link(const struct bpph_table *, int i);
+const char *bpph_get_self_link(const struct bpph_table *table, int i);
+const char *bpph_get_status(const struct bpph_table *table, int i);
+
+/*
+ * Returns the date after which the binary of an entry cannot be
+ * downloaded anymore: its removal date or, once it is superseded,
+ * deleted or obsolete, the date it was superseded. Returns 0 if the
+ * binary is still available.
+ */
+time_t bpph_get_date_frozen(const struct bpph_table *table, int i);
 
 char *get_archive_url(const char *owner, const char  *ppa);
 
+/* Returns the URL of the collection of the PPAs of an owner. */
+char *get_ppas_url(const char *owner);
+
 time_t ddts_get_last_date(struct daily_download_total **);
 
+/* Returns NULL if the merged vector cannot be allocated. */
 struct daily_download_total **
 ddts_merge(struct daily_download_total **,
 	   struct daily_download_total **);
@@ -0,0 +1,717 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <list.h>
+#include <lp_bin.h>
+#include <ptime.h>
+#include <strpool.h>
+
+static const char LP_BIN_MAGIC[4] = { '\0', 'P', 'P', 'S' };
+
+/* Version of the format, to increase on any change of the layout. */
+static const uint32_t LP_BIN_VERSION = 1;
+
+enum lp_bin_type {
+	LP_BIN_BPPH = 1,
+	LP_BIN_DDTS,
+	LP_BIN_DISTROS
+};
+
+struct lp_bin_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t type;
+	uint32_t length;
+};
+
+struct buffer {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+struct reader {
+	const char *data;
+	const char *end;
+};
+
+static void buffer_init(struct buffer *b, size_t size)
+{
+	b->size = size;
+	b->data = malloc(size);
+	b->len = 0;
+}
+
+/* Appends 'n' bytes, returns where they are to be written. */
+static char *put_space(struct buffer *b, size_t n)
+{
+	char *p;
+
+	if (b->len + n > b->size) {
+		while (b->len + n > b->size)
+			b->size *= 2;
+		b->data = realloc(b->data, b->size);
+	}
+
+	p = b->data + b->len;
+	b->len += n;
+
+	return p;
+}
+
+static void put(struct buffer *b, const void *data, size_t n)
+{
+	memcpy(put_space(b, n), data, n);
+}
+
+static void put_u32(struct buffer *b, uint32_t v)
+{
+	put(b, &v, sizeof(v));
+}
+
+/* Writes a section: its length followed by its content. */
+static void put_section(struct buffer *b, const void *data, size_t n)
+{
+	put_u32(b, n);
+	put(b, data, n);
+}
+
+/*
+ * Writes the length of a section, returns where its content is to be
+ * written. The place is valid until the next write.
+ */
+static char *put_section_space(struct buffer *b, size_t n)
+{
+	put_u32(b, n);
+
+	return put_space(b, n);
+}
+
+static void put_i32_at(char *p, int i, int32_t v)
+{
+	memcpy(p + i * sizeof(int32_t), &v, sizeof(v));
+}
+
+static void put_header(struct buffer *b, enum lp_bin_type type, int length)
+{
+	struct lp_bin_header h;
+
+	memcpy(h.magic, LP_BIN_MAGIC, sizeof(h.magic));
+	h.version = LP_BIN_VERSION;
+	h.type = type;
+	h.length = length;
+
+	put(b, &h, sizeof(h));
+}
+
+/* Returns a pointer to the next 'n' bytes or NULL if they are missing. */
+static const char *get(struct reader *r, size_t n)
+{
+	const char *p;
+
+	if (n > (size_t)(r->end - r->data))
+		return NULL;
+
+	p = r->data;
+	r->data += n;
+
+	return p;
+}
+
+static int get_u32(struct reader *r, uint32_t *v)
+{
+	const char *p;
+
+	p = get(r, sizeof(*v));
+	if (!p)
+		return -1;
+
+	memcpy(v, p, sizeof(*v));
+
+	return 0;
+}
+
+static void put_i64(struct buffer *b, int64_t v)
+{
+	put(b, &v, sizeof(v));
+}
+
+static int get_i64(struct reader *r, int64_t *v)
+{
+	const char *p;
+
+	p = get(r, sizeof(*v));
+	if (!p)
+		return -1;
+
+	memcpy(v, p, sizeof(*v));
+
+	return 0;
+}
+
+/* Returns the content of a section which must be 'n' bytes long. */
+static const char *get_section(struct reader *r, size_t n)
+{
+	uint32_t len;
+
+	if (get_u32(r, &len) || len != n)
+		return NULL;
+
+	return get(r, n);
+}
+
+static int
+get_header(struct reader *r, const char *data, size_t size,
+	   enum lp_bin_type type, int *length)
+{
+	struct lp_bin_header h;
+
+	if (!is_lp_bin(data, size))
+		return -1;
+
+	r->data = data;
+	r->end = data + size;
+
+	memcpy(&h, get(r, sizeof(h)), sizeof(h));
+
+	if (h.version != LP_BIN_VERSION || h.type != type)
+		return -1;
+
+	/* each row takes at least one byte */
+	if (h.length > INT_MAX || h.length > size)
+		return -1;
+
+	*length = h.length;
+
+	return 0;
+}
+
+int is_lp_bin(const char *data, size_t size)
+{
+	return size >= sizeof(struct lp_bin_header)
+		&& !memcmp(data, LP_BIN_MAGIC, sizeof(LP_BIN_MAGIC));
+}
+
+static void put_strpool(struct buffer *b, const struct strpool *pool)
+{
+	put_u32(b, pool->count);
+	put_section(b, pool->blob, pool->blob_size);
+}
+
+/*
+ * Adds to 'pool' the strings of a section, they must be distinct and
+ * get the ids following the ones of the pool.
+ */
+static int get_strpool(struct reader *r, struct strpool *pool)
+{
+	const char *blob, *end, *str;
+	uint32_t count, size;
+
+	if (get_u32(r, &count) || get_u32(r, &size))
+		return -1;
+
+	blob = get(r, size);
+	if (!blob || (size && blob[size - 1]))
+		return -1;
+
+	end = blob + size;
+	for (str = blob; str < end; str += strlen(str) + 1)
+		if (strpool_add(pool, str) != pool->count - 1)
+			return -1;
+
+	return pool->count == count ? 0 : -1;
+}
+
+/* Copies a column of string ids, which must be valid in 'pool'. */
+static int
+get_ids(struct reader *r, int *ids, int n, const struct strpool *pool)
+{
+	const char *p;
+	int i;
+
+	p = get_section(r, n * sizeof(int32_t));
+	if (!p)
+		return -1;
+
+	memcpy(ids, p, n * sizeof(int32_t));
+
+	for (i = 0; i < n; i++)
+		if (ids[i] < 0 || ids[i] >= pool->count)
+			return -1;
+
+	return 0;
+}
+
+/* Writes a column of times as 64 bits integers. */
+static void put_times(struct buffer *b, const time_t *times, int n)
+{
+	int64_t t;
+	char *p;
+	int i;
+
+	p = put_section_space(b, n * sizeof(int64_t));
+	for (i = 0; i < n; i++) {
+		t = times[i];
+		memcpy(p + i * sizeof(int64_t), &t, sizeof(t));
+	}
+}
+
+static int get_times(struct reader *r, time_t *times, int n)
+{
+	const char *p;
+	int64_t t;
+	int i;
+
+	p = get_section(r, n * sizeof(int64_t));
+	if (!p)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		memcpy(&t, p + i * sizeof(int64_t), sizeof(int64_t));
+		times[i] = t;
+	}
+
+	return 0;
+}
+
+/*
+ * The table is stored as the day of its last full retrieval followed
+ * by its string pools and by its columns.
+ */
+char *bpph_table_to_bin(const struct bpph_table *table,
+			long synced,
+			size_t *size)
+{
+	struct buffer b;
+	int n;
+
+	n = table->length;
+
+	buffer_init(&b,
+		    sizeof(struct lp_bin_header)
+		    + table->strings->blob_size
+		    + table->self_links->blob_size
+		    + n * (4 * sizeof(int32_t) + 3 * sizeof(int64_t) + 1)
+		    + 64);
+
+	put_header(&b, LP_BIN_BPPH, n);
+
+	put_u32(&b, (int32_t)synced);
+
+	put_strpool(&b, table->strings);
+	put_strpool(&b, table->self_links);
+
+	put_section(&b, table->binary_package_name, n * sizeof(int32_t));
+	put_section(&b, table->binary_package_version, n * sizeof(int32_t));
+	put_section(&b, table->distro_arch_series_link, n * sizeof(int32_t));
+	put_section(&b, table->status, n * sizeof(int32_t));
+	put_section(&b, table->architecture_specific, n);
+
+	put_times(&b, table->date_created, n);
+	put_times(&b, table->date_superseded, n);
+	put_times(&b, table->date_removed, n);
+
+	*size = b.len;
+
+	return b.data;
+}
+
+struct bpph_table *
+bin_to_bpph_table(const char *data, size_t size, long *synced)
+{
+	struct reader r;
+	struct bpph_table *table;
+	const char *p;
+	uint32_t s;
+	int n;
+
+	if (get_header(&r, data, size, LP_BIN_BPPH, &n)
+	    || get_u32(&r, &s))
+		return NULL;
+
+	table = bpph_table_new();
+	bpph_table_reserve(table, n);
+
+	if (get_strpool(&r, table->strings)
+	    || get_strpool(&r, table->self_links)
+	    || table->self_links->count != n)
+		goto on_error;
+
+	if (get_ids(&r, table->binary_package_name, n, table->strings)
+	    || get_ids(&r, table->binary_package_version, n, table->strings)
+	    || get_ids(&r, table->distro_arch_series_link, n, table->strings)
+	    || get_ids(&r, table->status, n, table->strings))
+		goto on_error;
+
+	p = get_section(&r, n);
+	if (!p)
+		goto on_error;
+	memcpy(table->architecture_specific, p, n);
+
+	if (get_times(&r, table->date_created, n)
+	    || get_times(&r, table->date_superseded, n)
+	    || get_times(&r, table->date_removed, n))
+		goto on_error;
+
+	table->length = n;
+	*synced = (int32_t)s;
+
+	return table;
+
+ on_error:
+	bpph_table_free(table);
+	return NULL;
+}
+
+/*
+ * The totals are stored as their retrieval state followed by two
+ * columns: the dates as numbers of days since the epoch and the counts.
+ */
+char *ddts_to_bin(struct daily_download_total **ddts,
+		  const struct ddts_state *state,
+		  size_t *size)
+{
+	struct buffer b;
+	struct tm *tm;
+	char *p;
+	int i, n;
+
+	n = ddts ? vector_length((void **)ddts) : 0;
+
+	buffer_init(&b, sizeof(struct lp_bin_header) + n * 8 + 40);
+
+	put_header(&b, LP_BIN_DDTS, n);
+
+	put_u32(&b, (int32_t)state->finalized);
+	put_i64(&b, state->refreshed);
+	put_u32(&b, state->interval);
+	put_u32(&b, state->velocity);
+
+	p = put_section_space(&b, n * sizeof(int32_t));
+	for (i = 0; i < n; i++) {
+		tm = &ddts[i]->date;
+		put_i32_at(p, i, date_to_days(tm->tm_year + 1900,
+					      tm->tm_mon + 1,
+					      tm->tm_mday));
+	}
+
+	p = put_section_space(&b, n * sizeof(int32_t));
+	for (i = 0; i < n; i++)
+		put_i32_at(p, i, ddts[i]->count);
+
+	*size = b.len;
+
+	return b.data;
+}
+
+static int get_ddts_state(struct reader *r,
+			  const char *data,
+			  size_t size,
+			  struct ddts_state *state,
+			  int *n)
+{
+	uint32_t finalized, interval, velocity;
+	int64_t refreshed;
+
+	if (get_header(r, data, size, LP_BIN_DDTS, n)
+	    || get_u32(r, &finalized)
+	    || get_i64(r, &refreshed)
+	    || get_u32(r, &interval)
+	    || get_u32(r, &velocity))
+		return -1;
+
+	state->finalized = (int32_t)finalized;
+	state->refreshed = refreshed;
+	state->interval = interval;
+	state->velocity = velocity;
+
+	return 0;
+}
+
+int bin_to_ddts_state(const char *data, size_t size, struct ddts_state *s)
+{
+	struct reader r;
+	int n;
+
+	return get_ddts_state(&r, data, size, s, &n);
+}
+
+struct daily_download_total **
+bin_to_ddts(const char *data, size_t size, struct ddts_state *state)
+{
+	struct reader r;
+	struct ddts_state s;
+	const char *days, *counts;
+	void **ddts;
+	struct daily_download_total *ddt;
+	int32_t d;
+	int i, n, y, m;
+
+	if (get_ddts_state(&r, data, size, &s, &n))
+		return NULL;
+
+	days = get_section(&r, n * sizeof(int32_t));
+	counts = get_section(&r, n * sizeof(int32_t));
+	if (!days || !counts)
+		return NULL;
+
+	*state = s;
+
+	ddts = vector_new(n);
+	if (!ddts)
+		return NULL;
+
+	/* the capacity is reserved, the vector does not grow */
+	for (i = 0; i < n; i++) {
+		ddt = malloc(sizeof(struct daily_download_total));
+		if (!ddt) {
+			daily_download_total_list_free
+				((struct daily_download_total **)ddts);
+			return NULL;
+		}
+
+		memcpy(&ddt->count, counts + i * sizeof(int32_t), sizeof(d));
+
+		memcpy(&d, days + i * sizeof(int32_t), sizeof(d));
+		memset(&ddt->date, 0, sizeof(struct tm));
+		days_to_date(d, &y, &m, &ddt->date.tm_mday);
+		ddt->date.tm_year = y - 1900;
+		ddt->date.tm_mon = m - 1;
+
+		ddts = vector_push(ddts, ddt);
+	}
+
+	return (struct daily_download_total **)ddts;
+}
+
+/* Adds the strings to 'pool' and writes their ids as a section. */
+static void
+put_strings(struct buffer *b, struct strpool *pool, char **str, int n)
+{
+	char *p;
+	int i;
+
+	p = put_section_space(b, n * sizeof(int32_t));
+	for (i = 0; i < n; i++)
+		put_i32_at(p, i, strpool_add(pool, str[i]));
+}
+
+/*
+ * Adds to 'pool' the string member at 'offset' of each object and
+ * writes their ids as a section.
+ */
+static void put_string_members(struct buffer *b, struct strpool *pool,
+			       void **objects, int n, size_t offset)
+{
+	const char *str;
+	char *p;
+	int i;
+
+	p = put_section_space(b, n * sizeof(int32_t));
+	for (i = 0; i < n; i++) {
+		str = *(char **)((char *)objects[i] + offset);
+		put_i32_at(p, i, strpool_add(pool, str));
+	}
+}
+
+/*
+ * Returns a column of string ids, which must be valid in 'pool', or
+ * NULL if it is invalid.
+ */
+static const char *
+get_id_column(struct reader *r, int n, const struct strpool *pool)
+{
+	const char *p;
+	int32_t id;
+	int i;
+
+	p = get_section(r, n * sizeof(int32_t));
+	if (!p)
+		return NULL;
+
+	for (i = 0; i < n; i++) {
+		memcpy(&id, p + i * sizeof(int32_t), sizeof(id));
+		if (id < 0 || id >= pool->count)
+			return NULL;
+	}
+
+	return p;
+}
+
+/* Returns the string of the row 'i' of a column of ids. */
+static const char *
+get_string(const struct strpool *pool, const char *column, int i)
+{
+	int32_t id;
+
+	memcpy(&id, column + i * sizeof(int32_t), sizeof(id));
+
+	return strpool_get(pool, id);
+}
+
+/*
+ * The snapshot is stored as its number of distro series and its date
+ * followed by a string pool and by one column of ids per field: the
+ * URLs and the fields of the distro arch series, their nominated flags,
+ * then the URLs and the fields of the distro series.
+ */
+char *distro_snapshot_to_bin(const struct distro_snapshot *s, size_t *size)
+{
+	struct buffer b, cols;
+	struct strpool *pool;
+	void **a, **d;
+	char *nominated;
+	int i, n, m;
+
+	a = (void **)s->arch_series;
+	d = (void **)s->series;
+	n = vector_length(a);
+	m = vector_length(d);
+
+	/* the columns are encoded first to fill the pool preceding them */
+	pool = strpool_new();
+	buffer_init(&cols, (n * 5 + m * 5) * (sizeof(int32_t) + 4) + n + 64);
+
+	put_strings(&cols, pool, s->arch_series_urls, n);
+	put_string_members(&cols, pool, a, n,
+			   offsetof(struct distro_arch_series, display_name));
+	put_string_members(&cols, pool, a, n,
+			   offsetof(struct distro_arch_series, title));
+	put_string_members(&cols, pool, a, n,
+			   offsetof(struct distro_arch_series,
+				    architecture_tag));
+	put_string_members(&cols, pool, a, n,
+			   offsetof(struct distro_arch_series,
+				    distroseries_link));
+	nominated = put_section_space(&cols, n);
+	for (i = 0; i < n; i++)
+		nominated[i] = !!s->arch_series[i]->is_nominated_arch_indep;
+
+	put_strings(&cols, pool, s->series_urls, m);
+	put_string_members(&cols, pool, d, m,
+			   offsetof(struct distro_series, displayname));
+	put_string_members(&cols, pool, d, m,
+			   offsetof(struct distro_series, name));
+	put_string_members(&cols, pool, d, m,
+			   offsetof(struct distro_series, version));
+	put_string_members(&cols, pool, d, m,
+			   offsetof(struct distro_series, title));
+
+	buffer_init(&b,
+		    sizeof(struct lp_bin_header)
+		    + pool->blob_size
+		    + cols.len
+		    + 64);
+
+	put_header(&b, LP_BIN_DISTROS, n);
+	put_u32(&b, m);
+	put_i64(&b, s->date);
+	put_strpool(&b, pool);
+	put(&b, cols.data, cols.len);
+
+	free(cols.data);
+	strpool_free(pool);
+
+	*size = b.len;
+
+	return b.data;
+}
+
+struct distro_snapshot *bin_to_distro_snapshot(const char *data, size_t size)
+{
+	struct reader r;
+	struct distro_snapshot *s;
+	struct strpool *pool;
+	struct distro_arch_series *a;
+	struct distro_series *d;
+	const char *f[5], *nominated;
+	uint32_t m;
+	int64_t date;
+	int i, j, n;
+
+	if (get_header(&r, data, size, LP_BIN_DISTROS, &n)
+	    || get_u32(&r, &m)
+	    || m > size
+	    || get_i64(&r, &date))
+		return NULL;
+
+	s = distro_snapshot_new(date);
+	if (!s)
+		return NULL;
+
+	pool = strpool_new();
+
+	if (get_strpool(&r, pool))
+		goto on_error;
+
+	for (j = 0; j < 5; j++)
+		if (!(f[j] = get_id_column(&r, n, pool)))
+			goto on_error;
+
+	nominated = get_section(&r, n);
+	if (!nominated)
+		goto on_error;
+
+	for (i = 0; i < n; i++) {
+		a = distro_arch_series_new(get_string(pool, f[1], i),
+					   get_string(pool, f[2], i),
+					   get_string(pool, f[3], i),
+					   nominated[i],
+					   get_string(pool, f[4], i));
+		if (distro_snapshot_add_arch_series(s,
+						    get_string(pool, f[0], i),
+						    a)) {
+			distro_arch_series_free(a);
+			goto on_error;
+		}
+	}
+
+	for (j = 0; j < 5; j++)
+		if (!(f[j] = get_id_column(&r, m, pool)))
+			goto on_error;
+
+	for (i = 0; i < (int)m; i++) {
+		d = distro_series_new(get_string(pool, f[2], i),
+				      get_string(pool, f[3], i),
+				      get_string(pool, f[4], i),
+				      get_string(pool, f[1], i));
+		if (distro_snapshot_add_series(s,
+					       get_string(pool, f[0], i),
+					       d)) {
+			distro_series_free(d);
+			goto on_error;
+		}
+	}
+
+	strpool_free(pool);
+
+	return s;
+
+ on_error:
+	strpool_free(pool);
+	distro_snapshot_free(s, 1);
+
+	return NULL;
+}
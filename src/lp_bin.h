@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_LP_BIN_H_
+#define _PPASTATS_LP_BIN_H_
+
+#include <stddef.h>
+
+#include "lp.h"
+
+/*
+ * Binary encoding of the cached bpph tables, daily download totals and
+ * distro snapshots.
+ *
+ * An entry starts with a header made of a magic number, a format
+ * version, the type of the entry and its number of rows. The rows
+ * follow as length-prefixed sections: the string pools then one
+ * array per column, in the byte order of the host. Loading an entry
+ * is mostly copying the sections into the columns.
+ *
+ * The first byte of the magic number is '\0' so a binary entry cannot
+ * be confused with a JSON one written by older releases. Entries of
+ * another version or byte order are rejected.
+ */
+
+/* Returns 1 if 'data' is a binary entry, 0 if it is anything else. */
+int is_lp_bin(const char *data, size_t size);
+
+/*
+ * Returns the encoding of a table, its size is stored in 'size'.
+ * 'synced' is the day number of the last retrieval of all its entries.
+ */
+char *bpph_table_to_bin(const struct bpph_table *table,
+			long synced,
+			size_t *size);
+
+/*
+ * Returns the decoded table and stores its day of last full retrieval
+ * in 'synced', or returns NULL if the entry is invalid.
+ */
+struct bpph_table *
+bin_to_bpph_table(const char *data, size_t size, long *synced);
+
+/* Returns the encoding of a list of totals, its size in 'size'. */
+char *ddts_to_bin(struct daily_download_total **ddts,
+		  const struct ddts_state *state,
+		  size_t *size);
+
+/*
+ * Returns the decoded totals and stores their retrieval state in
+ * 'state', or returns NULL if the entry is invalid.
+ */
+struct daily_download_total **
+bin_to_ddts(const char *data, size_t size, struct ddts_state *state);
+
+/* Decodes only the retrieval state, returns 0 or -1 if invalid. */
+int bin_to_ddts_state(const char *data, size_t size, struct ddts_state *s);
+
+/* Returns the encoding of a distro snapshot, its size in 'size'. */
+char *distro_snapshot_to_bin(const struct distro_snapshot *s, size_t *size);
+
+/*
+ * Returns the decoded snapshot, which owns its objects, or NULL if the
+ * entry is invalid.
+ */
+struct distro_snapshot *bin_to_distro_snapshot(const char *data, size_t size);
+
+#endif
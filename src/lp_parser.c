@@ -0,0 +1,746 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <list.h>
+#include <lp_parser.h>
+#include <ptime.h>
+
+/* Maximum nesting of the skipped values. */
+#define MAX_DEPTH 64
+
+struct parser {
+	char *cur;
+	int depth;
+};
+
+static void skip_ws(struct parser *p)
+{
+	while (*p->cur == ' '
+	       || *p->cur == '\n'
+	       || *p->cur == '\r'
+	       || *p->cur == '\t')
+		p->cur++;
+}
+
+/* Consumes the character 'c' which may be preceded by white spaces. */
+static int expect(struct parser *p, char c)
+{
+	skip_ws(p);
+
+	if (*p->cur != c)
+		return -1;
+
+	p->cur++;
+
+	return 0;
+}
+
+static int parse_literal(struct parser *p, const char *literal)
+{
+	int n;
+
+	skip_ws(p);
+
+	n = strlen(literal);
+	if (strncmp(p->cur, literal, n))
+		return -1;
+
+	p->cur += n;
+
+	return 0;
+}
+
+static int hex4_to_int(const char *s)
+{
+	int i, v;
+
+	v = 0;
+	for (i = 0; i < 4; i++) {
+		v <<= 4;
+
+		if (s[i] >= '0' && s[i] <= '9')
+			v |= s[i] - '0';
+		else if (s[i] >= 'a' && s[i] <= 'f')
+			v |= s[i] - 'a' + 10;
+		else if (s[i] >= 'A' && s[i] <= 'F')
+			v |= s[i] - 'A' + 10;
+		else
+			return -1;
+	}
+
+	return v;
+}
+
+/* Writes the UTF-8 encoding of 'c', returns the number of bytes. */
+static int utf8_encode(char *dst, unsigned int c)
+{
+	if (c < 0x80) {
+		dst[0] = c;
+		return 1;
+	}
+
+	if (c < 0x800) {
+		dst[0] = 0xc0 | (c >> 6);
+		dst[1] = 0x80 | (c & 0x3f);
+		return 2;
+	}
+
+	if (c < 0x10000) {
+		dst[0] = 0xe0 | (c >> 12);
+		dst[1] = 0x80 | ((c >> 6) & 0x3f);
+		dst[2] = 0x80 | (c & 0x3f);
+		return 3;
+	}
+
+	dst[0] = 0xf0 | (c >> 18);
+	dst[1] = 0x80 | ((c >> 12) & 0x3f);
+	dst[2] = 0x80 | ((c >> 6) & 0x3f);
+	dst[3] = 0x80 | (c & 0x3f);
+	return 4;
+}
+
+/*
+ * Parses a string and decodes it in place: an escape sequence is never
+ * shorter than its decoding so the decoded string and its null
+ * terminator fit in the quoted one.
+ */
+static int parse_string(struct parser *p, char **str)
+{
+	char *src, *dst;
+	int c, c2;
+
+	if (expect(p, '"'))
+		return -1;
+
+	src = p->cur;
+	dst = p->cur;
+
+	while (*src != '"') {
+		if (!*src)
+			return -1;
+
+		if (*src != '\\') {
+			*dst++ = *src++;
+			continue;
+		}
+
+		src++;
+		switch (*src++) {
+		case '"':
+			*dst++ = '"';
+			break;
+		case '\\':
+			*dst++ = '\\';
+			break;
+		case '/':
+			*dst++ = '/';
+			break;
+		case 'b':
+			*dst++ = '\b';
+			break;
+		case 'f':
+			*dst++ = '\f';
+			break;
+		case 'n':
+			*dst++ = '\n';
+			break;
+		case 'r':
+			*dst++ = '\r';
+			break;
+		case 't':
+			*dst++ = '\t';
+			break;
+		case 'u':
+			c = hex4_to_int(src);
+			if (c == -1)
+				return -1;
+			src += 4;
+
+			/* surrogate pair */
+			if (c >= 0xd800 && c < 0xdc00
+			    && src[0] == '\\' && src[1] == 'u') {
+				c2 = hex4_to_int(src + 2);
+				if (c2 >= 0xdc00 && c2 < 0xe000) {
+					c = 0x10000
+						+ ((c - 0xd800) << 10)
+						+ (c2 - 0xdc00);
+					src += 6;
+				}
+			}
+
+			dst += utf8_encode(dst, c);
+			break;
+		default:
+			return -1;
+		}
+	}
+
+	*dst = '\0';
+	*str = p->cur;
+	p->cur = src + 1;
+
+	return 0;
+}
+
+static int parse_string_or_null(struct parser *p, char **str)
+{
+	skip_ws(p);
+
+	if (*p->cur == 'n') {
+		*str = NULL;
+		return parse_literal(p, "null");
+	}
+
+	return parse_string(p, str);
+}
+
+static int parse_boolean(struct parser *p, int *b)
+{
+	skip_ws(p);
+
+	*b = *p->cur == 't';
+
+	switch (*p->cur) {
+	case 't':
+		return parse_literal(p, "true");
+	case 'f':
+		return parse_literal(p, "false");
+	default:
+		return parse_literal(p, "null");
+	}
+}
+
+/* Parses a number, its fractional part is ignored. */
+static int parse_int(struct parser *p, int *v)
+{
+	char *end;
+
+	skip_ws(p);
+
+	*v = strtol(p->cur, &end, 10);
+	if (end == p->cur)
+		return -1;
+
+	while (*end == '.'
+	       || *end == 'e'
+	       || *end == 'E'
+	       || *end == '+'
+	       || *end == '-'
+	       || (*end >= '0' && *end <= '9'))
+		end++;
+
+	p->cur = end;
+
+	return 0;
+}
+
+static int skip_value(struct parser *p);
+
+/*
+ * Parses an object, 'member' is called with the key of each member and
+ * must consume its value. The values are skipped if 'member' is NULL.
+ */
+static int
+parse_object(struct parser *p,
+	     int (*member)(struct parser *p, const char *key, void *data),
+	     void *data)
+{
+	char *key;
+	int ret;
+
+	if (expect(p, '{'))
+		return -1;
+
+	skip_ws(p);
+	if (*p->cur == '}') {
+		p->cur++;
+		return 0;
+	}
+
+	while (1) {
+		if (parse_string(p, &key) || expect(p, ':'))
+			return -1;
+
+		if (member)
+			ret = member(p, key, data);
+		else
+			ret = skip_value(p);
+
+		if (ret)
+			return -1;
+
+		skip_ws(p);
+		switch (*p->cur++) {
+		case ',':
+			break;
+		case '}':
+			return 0;
+		default:
+			return -1;
+		}
+	}
+}
+
+/*
+ * Parses an array, 'element' is called for each element and must
+ * consume it. The elements are skipped if 'element' is NULL.
+ */
+static int parse_array(struct parser *p,
+		       int (*element)(struct parser *p, void *data),
+		       void *data)
+{
+	int ret;
+
+	if (expect(p, '['))
+		return -1;
+
+	skip_ws(p);
+	if (*p->cur == ']') {
+		p->cur++;
+		return 0;
+	}
+
+	while (1) {
+		if (element)
+			ret = element(p, data);
+		else
+			ret = skip_value(p);
+
+		if (ret)
+			return -1;
+
+		skip_ws(p);
+		switch (*p->cur++) {
+		case ',':
+			break;
+		case ']':
+			return 0;
+		default:
+			return -1;
+		}
+	}
+}
+
+static int skip_string(struct parser *p)
+{
+	char *s;
+
+	if (expect(p, '"'))
+		return -1;
+
+	for (s = p->cur; *s != '"'; s++) {
+		if (!*s)
+			return -1;
+
+		if (*s == '\\' && !*++s)
+			return -1;
+	}
+
+	p->cur = s + 1;
+
+	return 0;
+}
+
+static int skip_value(struct parser *p)
+{
+	int ret, v;
+
+	skip_ws(p);
+
+	switch (*p->cur) {
+	case '"':
+		return skip_string(p);
+	case '{':
+	case '[':
+		if (p->depth == MAX_DEPTH)
+			return -1;
+
+		p->depth++;
+		if (*p->cur == '{')
+			ret = parse_object(p, NULL, NULL);
+		else
+			ret = parse_array(p, NULL, NULL);
+		p->depth--;
+
+		return ret;
+	case 't':
+		return parse_literal(p, "true");
+	case 'f':
+		return parse_literal(p, "false");
+	case 'n':
+		return parse_literal(p, "null");
+	default:
+		return parse_int(p, &v);
+	}
+}
+
+static void parser_init(struct parser *p, char *json)
+{
+	p->cur = json;
+	p->depth = 0;
+}
+
+static time_t str_to_time(const char *str)
+{
+	time_t t;
+
+	if (str && !ISO8601_time_to_time(str, &t))
+		return t;
+	else
+		return -1;
+}
+
+struct bpph_page {
+	void (*cbk)(const struct bpph_entry *, void *);
+	void *data;
+	char *next_collection_link;
+	int total_size;
+};
+
+static int bpph_entry_member(struct parser *p, const char *key, void *data)
+{
+	struct bpph_entry *e;
+	char *str;
+
+	e = data;
+
+	if (!strcmp(key, "binary_package_name"))
+		return parse_string_or_null(p, &e->binary_package_name);
+
+	if (!strcmp(key, "binary_package_version"))
+		return parse_string_or_null(p, &e->binary_package_version);
+
+	if (!strcmp(key, "distro_arch_series_link"))
+		return parse_string_or_null(p, &e->distro_arch_series_link);
+
+	if (!strcmp(key, "self_link"))
+		return parse_string_or_null(p, &e->self_link);
+
+	if (!strcmp(key, "status"))
+		return parse_string_or_null(p, &e->status);
+
+	if (!strcmp(key, "architecture_specific"))
+		return parse_boolean(p, &e->architecture_specific);
+
+	if (!strcmp(key, "date_created")) {
+		if (parse_string_or_null(p, &str))
+			return -1;
+
+		e->date_created = str_to_time(str);
+		return 0;
+	}
+
+	if (!strcmp(key, "date_superseded")) {
+		if (parse_string_or_null(p, &str))
+			return -1;
+
+		e->date_superseded = str ? str_to_time(str) : 0;
+		return 0;
+	}
+
+	if (!strcmp(key, "date_removed")) {
+		if (parse_string_or_null(p, &str))
+			return -1;
+
+		e->date_removed = str ? str_to_time(str) : 0;
+		return 0;
+	}
+
+	return skip_value(p);
+}
+
+static int bpph_page_entry(struct parser *p, void *data)
+{
+	struct bpph_page *page;
+	struct bpph_entry e;
+
+	page = data;
+
+	memset(&e, 0, sizeof(struct bpph_entry));
+	e.date_created = -1;
+
+	if (parse_object(p, bpph_entry_member, &e))
+		return -1;
+
+	page->cbk(&e, page->data);
+
+	return 0;
+}
+
+static int bpph_page_member(struct parser *p, const char *key, void *data)
+{
+	struct bpph_page *page;
+
+	page = data;
+
+	if (!strcmp(key, "entries"))
+		return parse_array(p, bpph_page_entry, page);
+
+	if (!strcmp(key, "next_collection_link"))
+		return parse_string_or_null(p, &page->next_collection_link);
+
+	if (!strcmp(key, "total_size"))
+		return parse_int(p, &page->total_size);
+
+	return skip_value(p);
+}
+
+int lp_parse_bpph_page(char *json,
+		       void (*cbk)(const struct bpph_entry *, void *),
+		       void *data,
+		       char **next_collection_link,
+		       int *total_size)
+{
+	struct parser p;
+	struct bpph_page page;
+
+	parser_init(&p, json);
+
+	page.cbk = cbk;
+	page.data = data;
+	page.next_collection_link = NULL;
+	page.total_size = -1;
+
+	if (parse_object(&p, bpph_page_member, &page))
+		return -1;
+
+	*next_collection_link = page.next_collection_link;
+	if (total_size)
+		*total_size = page.total_size;
+
+	return 0;
+}
+
+static int ddts_member(struct parser *p, const char *key, void *data)
+{
+	void ***ddts, **result;
+	struct daily_download_total *ddt;
+	int count;
+
+	ddts = data;
+
+	if (parse_int(p, &count))
+		return -1;
+
+	ddt = malloc(sizeof(struct daily_download_total));
+	if (!ddt)
+		return -1;
+
+	ddt->count = count;
+
+	memset(&ddt->date, 0, sizeof(struct tm));
+	if (ISO8601_date_to_tm(key, &ddt->date)) {
+		free(ddt);
+		return -1;
+	}
+
+	result = vector_push(*ddts, ddt);
+	if (!result) {
+		free(ddt);
+		return -1;
+	}
+	*ddts = result;
+
+	return 0;
+}
+
+struct daily_download_total **lp_parse_daily_download_totals(char *json)
+{
+	struct parser p;
+	void **ddts;
+
+	parser_init(&p, json);
+
+	ddts = vector_new(0);
+
+	if (parse_object(&p, ddts_member, &ddts)) {
+		daily_download_total_list_free
+			((struct daily_download_total **)ddts);
+		return NULL;
+	}
+
+	return (struct daily_download_total **)ddts;
+}
+
+static int
+distro_arch_series_member(struct parser *p, const char *key, void *data)
+{
+	struct distro_arch_series *d;
+
+	d = data;
+
+	if (!strcmp(key, "display_name"))
+		return parse_string_or_null(p, &d->display_name);
+
+	if (!strcmp(key, "title"))
+		return parse_string_or_null(p, &d->title);
+
+	if (!strcmp(key, "architecture_tag"))
+		return parse_string_or_null(p, &d->architecture_tag);
+
+	if (!strcmp(key, "distroseries_link"))
+		return parse_string_or_null(p, &d->distroseries_link);
+
+	if (!strcmp(key, "is_nominated_arch_indep"))
+		return parse_boolean(p, &d->is_nominated_arch_indep);
+
+	return skip_value(p);
+}
+
+struct distro_arch_series *lp_parse_distro_arch_series(char *json)
+{
+	struct parser p;
+	struct distro_arch_series d;
+
+	parser_init(&p, json);
+
+	memset(&d, 0, sizeof(struct distro_arch_series));
+
+	if (parse_object(&p, distro_arch_series_member, &d))
+		return NULL;
+
+	if (!d.display_name || !d.title || !d.architecture_tag
+	    || !d.distroseries_link)
+		return NULL;
+
+	return distro_arch_series_new(d.display_name,
+				      d.title,
+				      d.architecture_tag,
+				      d.is_nominated_arch_indep,
+				      d.distroseries_link);
+}
+
+static int distro_series_member(struct parser *p, const char *key, void *data)
+{
+	struct distro_series *d;
+
+	d = data;
+
+	if (!strcmp(key, "displayname"))
+		return parse_string_or_null(p, &d->displayname);
+
+	if (!strcmp(key, "title"))
+		return parse_string_or_null(p, &d->title);
+
+	if (!strcmp(key, "version"))
+		return parse_string_or_null(p, &d->version);
+
+	if (!strcmp(key, "name"))
+		return parse_string_or_null(p, &d->name);
+
+	return skip_value(p);
+}
+
+struct distro_series *lp_parse_distro_series(char *json)
+{
+	struct parser p;
+	struct distro_series d;
+
+	parser_init(&p, json);
+
+	memset(&d, 0, sizeof(struct distro_series));
+
+	if (parse_object(&p, distro_series_member, &d))
+		return NULL;
+
+	if (!d.name || !d.version || !d.title || !d.displayname)
+		return NULL;
+
+	return distro_series_new(d.name, d.version, d.title, d.displayname);
+}
+
+struct ppas_page {
+	char **names;
+	char *next_collection_link;
+};
+
+static int ppa_member(struct parser *p, const char *key, void *data)
+{
+	if (!strcmp(key, "name"))
+		return parse_string_or_null(p, data);
+
+	return skip_value(p);
+}
+
+static int ppas_page_entry(struct parser *p, void *data)
+{
+	struct ppas_page *page;
+	char *name, *copy, **names;
+
+	page = data;
+	name = NULL;
+
+	if (parse_object(p, ppa_member, &name))
+		return -1;
+
+	if (name) {
+		copy = strdup(name);
+		names = (char **)vector_push((void **)page->names, copy);
+		if (!names) {
+			free(copy);
+			return -1;
+		}
+		page->names = names;
+	}
+
+	return 0;
+}
+
+static int ppas_page_member(struct parser *p, const char *key, void *data)
+{
+	struct ppas_page *page;
+
+	page = data;
+
+	if (!strcmp(key, "entries"))
+		return parse_array(p, ppas_page_entry, page);
+
+	if (!strcmp(key, "next_collection_link"))
+		return parse_string_or_null(p, &page->next_collection_link);
+
+	return skip_value(p);
+}
+
+char **lp_parse_ppa_names(char *json, char **next_collection_link)
+{
+	struct parser p;
+	struct ppas_page page;
+	char **name;
+
+	parser_init(&p, json);
+
+	page.names = (char **)vector_new(0);
+	page.next_collection_link = NULL;
+
+	if (parse_object(&p, ppas_page_member, &page)) {
+		for (name = page.names; name && *name; name++)
+			free(*name);
+		vector_free((void **)page.names);
+
+		return NULL;
+	}
+
+	*next_collection_link = page.next_collection_link;
+
+	return page.names;
+}
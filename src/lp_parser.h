@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_LP_PARSER_H_
+#define _PPASTATS_LP_PARSER_H_
+
+#include <time.h>
+
+#include "lp.h"
+
+/*
+ * Streaming parsers of the Launchpad JSON replies.
+ *
+ * The replies are parsed in a single pass without building a JSON
+ * tree: the fields used by ppastats are extracted on the fly, the
+ * other values are skipped. Strings are decoded in place, the parsed
+ * buffer is modified and the returned strings point into it.
+ *
+ * The functions fail if the reply is not valid JSON.
+ */
+
+/* Fields of an entry of a getPublishedBinaries reply. */
+struct bpph_entry {
+	char *binary_package_name;
+	char *binary_package_version;
+	char *distro_arch_series_link;
+	char *self_link;
+	char *status;
+	int architecture_specific;
+	time_t date_created;
+	/* 0 if null */
+	time_t date_superseded;
+	time_t date_removed;
+};
+
+/*
+ * Parses a page of a getPublishedBinaries reply, or its cached copy.
+ *
+ * 'cbk' is called for each entry as soon as it is parsed, possibly
+ * before an error is detected further in the reply. The fields point
+ * into 'json'. 'next_collection_link' is set to the link of the next
+ * page, pointing into 'json' too, or to NULL for the last one.
+ * 'total_size', if not NULL, is set to the number of entries of the
+ * whole collection or to -1 if the reply does not hold it.
+ *
+ * Returns 0 on success or -1 if the reply is invalid.
+ */
+int lp_parse_bpph_page(char *json,
+		       void (*cbk)(const struct bpph_entry *entry, void *data),
+		       void *data,
+		       char **next_collection_link,
+		       int *total_size);
+
+/*
+ * Parses a getDailyDownloadTotals reply, or its cached copy.
+ *
+ * Returns NULL if the reply is invalid.
+ */
+struct daily_download_total **lp_parse_daily_download_totals(char *json);
+
+/*
+ * Parses a distro arch series or a distro series.
+ *
+ * Returns NULL if the object is invalid or if one of its strings is
+ * missing or null.
+ */
+struct distro_arch_series *lp_parse_distro_arch_series(char *json);
+
+struct distro_series *lp_parse_distro_series(char *json);
+
+/*
+ * Parses a page of the collection of the PPAs of an owner.
+ *
+ * Returns the vector of the names of the PPAs, copies of the parsed
+ * ones, or NULL if the reply is invalid. 'next_collection_link' is set
+ * like for lp_parse_bpph_page().
+ */
+char **lp_parse_ppa_names(char *json, char **next_collection_link);
+
+#endif
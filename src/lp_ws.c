@@ -20,27 +20,56 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
 #include <time.h>
 
 #include <json.h>
 
-#include <cache.h>
 #include <fcache.h>
+#include <hashmap.h>
 #include <http.h>
 #include <list.h>
 #include <lp_ws.h>
-#include <lp_json.h>
+#include <lp_bin.h>
+#include <lp_parser.h>
+#include <pio.h>
 #include <plog.h>
 #include <ppastats.h>
 #include <ptime.h>
+#include <scheduler.h>
+#include <workers.h>
 
 /** Default ws.size value for the getPublishedBinaries request. */
 static const int DEFAULT_WS_SIZE = 150;
 
+/** Number of days after which the download totals of a day are final. */
+static int settling_days = 28;
+
+static const int DAY_SECONDS = 24 * 60 * 60;
+
+/*
+ * Number of days after which all the bpph entries are retrieved again
+ * for updating the status of the cached ones.
+ */
+static const int BPPH_RESYNC_DAYS = 7;
+
+/* Bounds of the delay between retrievals of the ddts of quiet binaries */
+static const int REFRESH_MIN_INTERVAL = 60 * 60;
+static const int REFRESH_MAX_INTERVAL = 7 * 24 * 60 * 60;
+
+/*
+ * Maximal number of concurrent requests of a retrieval: getPublishedBinaries
+ * pages, distro_arch_series or ranges recovering a failed retrieval.
+ */
+static int max_jobs = 1;
+
+/* Page sizes tried by the automatic mode, the default one first */
+#define N_AUTO_WS_SIZES 3
+static const int AUTO_WS_SIZES[N_AUTO_WS_SIZES] = { 150, 300, 75 };
+
 static const char *QUERY_GET_DOWNLOAD_COUNT = "?ws.op=getDownloadCount";
 static const char *
 QUERY_GET_DAILY_DOWNLOAD_TOTALS = "?ws.op=getDailyDownloadTotals";
@@ -83,145 +112,766 @@ static char *get_ddts_list_cache_key(const char *url)
 	return key;
 }
 
-static struct bpph **get_bpph_list_from_cache(const char *key)
+static void add_bpph_entry(const struct bpph_entry *e, void *data)
 {
-	char *content;
-	struct bpph **list;
-	json_object *json;
+	bpph_table_add(data,
+		       e->binary_package_name,
+		       e->binary_package_version,
+		       e->distro_arch_series_link,
+		       e->self_link,
+		       e->status,
+		       e->architecture_specific,
+		       e->date_created,
+		       e->date_superseded,
+		       e->date_removed);
+}
 
-	content = fcache_get(key);
-	if (!content)
+static void retrieve_distro_arch_series(int i, void *data)
+{
+	get_distro_arch_series(((const char **)data)[i]);
+}
+
+/*
+ * Returns the entries of 'page' which are architecture specific or
+ * published in the nominated architecture, or NULL if it fails. 'page'
+ * is freed.
+ *
+ * The distro_arch_series of the architecture independent entries which
+ * are not known yet are retrieved concurrently in one batch instead of
+ * one after another while parsing.
+ */
+static struct bpph_table *select_bpph_entries(struct bpph_table *page)
+{
+	const struct distro_arch_series *distro;
+	struct bpph_table *selected;
+	const char **links;
+	char *seen;
+	int i, id, n;
+
+	if (!page->length)
+		return page;
+
+	links = malloc(page->length * sizeof(char *));
+	seen = calloc(page->strings->count, 1);
+	if (!links || !seen) {
+		free(links);
+		free(seen);
+		bpph_table_free(page);
+		return NULL;
+	}
+
+	n = 0;
+	for (i = 0; i < page->length; i++) {
+		id = page->distro_arch_series_link[i];
+
+		if (page->architecture_specific[i] || seen[id])
+			continue;
+		seen[id] = 1;
+
+		links[n++] = bpph_get_distro_arch_series_link(page, i);
+	}
+
+	free(seen);
+
+	if (!n) {
+		free(links);
+		return page;
+	}
+
+	workers_run(n,
+		    n < max_jobs ? n : max_jobs,
+		    retrieve_distro_arch_series,
+		    links);
+	free(links);
+
+	selected = bpph_table_new();
+
+	for (i = 0; i < page->length; i++) {
+		if (!page->architecture_specific[i]) {
+			distro = get_distro_arch_series
+				(bpph_get_distro_arch_series_link(page, i));
+
+			if (!distro || !distro->is_nominated_arch_indep)
+				continue;
+		}
+
+		bpph_table_add_row(selected, page, i);
+	}
+
+	bpph_table_free(page);
+
+	return selected;
+}
+
+/*
+ * Returns the table of the entries of a getPublishedBinaries page or
+ * NULL if the page is invalid. 'total_size' may be NULL.
+ */
+static struct bpph_table *
+parse_bpph_page(char *json, char **next_link, int *total_size)
+{
+	struct bpph_table *table;
+
+	table = bpph_table_new();
+
+	if (lp_parse_bpph_page(json,
+			       add_bpph_entry,
+			       table,
+			       next_link,
+			       total_size)) {
+		bpph_table_free(table);
 		return NULL;
+	}
+
+	return select_bpph_entries(table);
+}
+
+/*
+ * Returns the cached table of 'key' and stores in 'synced' the day of
+ * its last full retrieval, 0 if unknown. When the entry is in the
+ * binary format, its content is stored in 'bin' for detecting later
+ * whether it changed, else 'bin' is set to NULL.
+ */
+static struct bpph_table *
+get_bpph_table_from_cache(const char *key,
+			  char **bin,
+			  size_t *size,
+			  long *synced)
+{
+	char *content, *next_link;
+	struct bpph_table *table;
 
-	json = json_tokener_parse(content);
-	if (!json)
+	*bin = NULL;
+	*synced = 0;
+
+	content = fcache_get_data(key, size);
+	if (!content)
 		return NULL;
 
-	list = json_object_to_bpph_list(json);
+	if (is_lp_bin(content, *size)) {
+		table = bin_to_bpph_table(content, *size, synced);
+		*bin = content;
+	} else { /* JSON entry of older releases, rewritten in binary */
+		table = parse_bpph_page(content, &next_link, NULL);
+		free(content);
+	}
 
-	json_object_put(json);
-	free(content);
+	if (!table)
+		log_debug(_("invalid cache entry %s"), key);
 
-	return list;
+	return table;
 }
 
-static char *get_last_creation_date(struct bpph **list)
+/*
+ * Stores an encoded entry in the file cache unless it is identical to
+ * 'cached', the binary content of the entry read from the cache. Most
+ * of the entries do not change from one run to the next one. 'bin' is
+ * freed.
+ */
+static void put_bin(const char *key,
+		    char *bin,
+		    size_t size,
+		    const char *cached,
+		    size_t cached_size)
+{
+	if (cached && size == cached_size && !memcmp(bin, cached, size))
+		log_debug(_("file cache unchanged %s"), key);
+	else
+		fcache_put_data(key, bin, size);
+
+	free(bin);
+}
+
+/*
+ * Formats into 'date' the most recent creation date of the entries.
+ *
+ * Returns 'date' or NULL if there is no creation date.
+ */
+static char *get_last_creation_date(const struct bpph_table *table,
+				    char *date)
 {
 	time_t last, t;
-	struct bpph **cur;
+	int i;
 
 	last = 0;
 
-	if (list)
-		for (cur = list; *cur; cur++) {
-			t = (*cur)->date_created;
-			if (t > last)
-				last = t;
-		}
+	for (i = 0; i < table->length; i++) {
+		t = table->date_created[i];
+		if (t > last)
+			last = t;
+	}
 
 	if (last)
-		return time_to_ISO8601_time(&last);
+		return time_to_ISO8601_time_r(last, date);
 	else
 		return NULL;
 }
 
+/* Returns 'size' if it is between 1-300, else the default value. */
+static int get_ws_size(int size)
+{
+	if (size < 1 || size > 300)
+		return DEFAULT_WS_SIZE;
+
+	return size;
+}
+
 /*
+ * Returns the getPublishedBinaries query of an archive without the
+ * ws.size and ws.start parameters of the pages. All the entries are
+ * retrieved whatever their status.
  * 'archive_url': LP URL of the archive.
- * 'size': size of the reply array. Between 1-300, else default value is used.
  */
-static char *create_query_get_bpph(const char *archive_url,
-				   const char *status,
-				   int size)
+static char *create_query_get_bpph(const char *archive_url)
 {
-	static const char *default_opt = "?ws.op=getPublishedBinaries&ws.size=";
-	static const char *status_opt = "&status=";
+	static const char *default_opt = "?ws.op=getPublishedBinaries";
 	char *url;
-	size_t n;
 
-	if (size < 1 || size > 300)
-		size = DEFAULT_WS_SIZE;
+	url = malloc(strlen(archive_url) + strlen(default_opt) + 1);
+	sprintf(url, "%s%s", archive_url, default_opt);
 
-	n = strlen(archive_url) + strlen(default_opt) + 3 + 1;
+	return url;
+}
 
-	if (status)
-		n += strlen(status_opt) + strlen(status);
+/* Returns the query of the page of 'size' entries from 'start'. */
+static char *create_bpph_page_query(const char *query, int size, int start)
+{
+	char *url;
 
-	url = malloc(n);
-	sprintf(url, "%s%s%d", archive_url, default_opt, size);
+	url = malloc(strlen(query)
+		     + strlen("&ws.size=") + 10
+		     + strlen("&ws.start=") + 10
+		     + 1);
 
-	if (status) {
-		strcat(url, status_opt);
-		strcat(url, status);
-	}
+	if (start)
+		sprintf(url, "%s&ws.size=%d&ws.start=%d", query, size, start);
+	else
+		sprintf(url, "%s&ws.size=%d", query, size);
 
 	return url;
 }
 
-struct bpph **get_bpph_list(const char *archive_url,
-			    const char *pkg_status,
-			    int ws_size)
+/*
+ * A bpph list being retrieved. The cache holds all the entries of the
+ * archive whatever their status, the status filter is applied locally.
+ */
+struct bpph_list {
+	/* all the entries */
+	struct bpph_table *all;
+	/* entries of the requested status, 'all' if there is no filter */
+	struct bpph_table *selected;
+	const char *status;
+
+	void (*cbk)(struct bpph_table *, void *);
+	void *data;
+};
+
+/*
+ * Appends the entries of 'src' to the list, 'src' is freed.
+ *
+ * Returns the new entries of the requested status to notify to the
+ * callback, or NULL if there are none.
+ */
+static struct bpph_table *
+merge_bpph_table(struct bpph_list *l, struct bpph_table *src)
+{
+	struct bpph_table *rows;
+	int n, n_new;
+
+	if (!src)
+		return NULL;
+
+	n = l->all->length;
+	n_new = bpph_table_add_table(l->all, src);
+
+	bpph_table_free(src);
+
+	if (!n_new || (!l->cbk && l->selected == l->all))
+		return NULL;
+
+	rows = bpph_table_filter(l->all, n, n_new, l->status);
+
+	if (l->selected != l->all)
+		bpph_table_add_table(l->selected, rows);
+
+	if (l->cbk && rows->length)
+		return rows;
+
+	bpph_table_free(rows);
+
+	return NULL;
+}
+
+/*
+ * Appends the entries of 'src' to the list and notifies the new ones
+ * of the requested status to the callback. 'src' is freed.
+ */
+static void add_bpph_table(struct bpph_list *l, struct bpph_table *src)
 {
-	char *url, *key, *tmp;
-	struct bpph **result;
-	struct json_object *o, *bpph_json, *o_next;
-	char *date;
-	int ok;
+	struct bpph_table *rows;
 
-	url = create_query_get_bpph(archive_url, pkg_status, ws_size);
+	rows = merge_bpph_table(l, src);
+	if (rows)
+		l->cbk(rows, l->data);
+}
 
-	key = get_bpph_list_cache_key(archive_url);
+/* Throughput measured for a page size of the automatic mode. */
+struct ws_size_stats {
+	int size;
+	/* requests in progress */
+	int pending;
+	int pages;
+	long entries;
+	double seconds;
+};
+
+/*
+ * Pages of a getPublishedBinaries collection. When the collection size
+ * is known, they are retrieved concurrently from their offsets and
+ * added to the table in the order of the collection as soon as all the
+ * previous ones have been retrieved.
+ */
+struct bpph_pages {
+	/* query without the ws.size and ws.start parameters */
+	const char *query;
+	/* size of the pages, 0 for choosing it from the throughput */
+	int ws_size;
+	struct ws_size_stats sizes[N_AUTO_WS_SIZES];
+
+	int total_size;
+	/* offset of the next page to retrieve */
+	int start;
+
+	/* pages handed out to the workers */
+	int n;
+	int capacity;
+	struct bpph_table **pages;
+	/* 1 once the page has been retrieved, even if it failed */
+	char *retrieved;
+	/* index of the next page to add to the table */
+	int next;
+	/* set once a page failed, no other page is handed out then */
+	int failed;
+	/* link following the last page */
+	char *next_link;
+
+	struct bpph_list *list;
+	/* merged entries not notified yet to the callback, in order */
+	struct bpph_table **rows;
+	int next_rows;
+	/* 1 while a worker notifies them, outside of the mutex */
+	int notifying;
+
+	pthread_mutex_t mutex;
+};
+
+static struct bpph_timings bpph_timings;
+static pthread_mutex_t bpph_timings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void get_bpph_timings(struct bpph_timings *timings)
+{
+	pthread_mutex_lock(&bpph_timings_mutex);
+	*timings = bpph_timings;
+	pthread_mutex_unlock(&bpph_timings_mutex);
+}
+
+/*
+ * Retrieves and parses a page. Its duration is stored in 'seconds',
+ * its content in 'body' which must be freed by the caller even if the
+ * page is invalid. 'next_link' points into 'body'.
+ */
+static struct bpph_table *get_bpph_page(const char *url,
+					char **body,
+					char **next_link,
+					int *total_size,
+					double *seconds)
+{
+	struct bpph_table *page;
+	double t;
+	size_t bytes;
+
+	t = get_monotonic_time();
+	*body = get_url_content(url, 0);
+	*seconds = get_monotonic_time() - t;
+
+	if (!*body)
+		return NULL;
+
+	bytes = strlen(*body);
+	page = parse_bpph_page(*body, next_link, total_size);
+
+	if (page) {
+		pthread_mutex_lock(&bpph_timings_mutex);
+		bpph_timings.pages++;
+		bpph_timings.entries += page->length;
+		bpph_timings.bytes += bytes;
+		bpph_timings.seconds += *seconds;
+		pthread_mutex_unlock(&bpph_timings_mutex);
+	}
+
+	return page;
+}
+
+static struct ws_size_stats *get_ws_size_stats(struct bpph_pages *p, int size)
+{
+	int i;
+
+	for (i = 0; i < N_AUTO_WS_SIZES; i++)
+		if (p->sizes[i].size == size)
+			return &p->sizes[i];
+
+	return NULL;
+}
+
+/*
+ * Returns the size of the next page. In automatic mode, each candidate
+ * size is tried once, then the one with the best number of entries per
+ * second is used. The measures go on with each page.
+ */
+static int choose_ws_size(struct bpph_pages *p)
+{
+	struct ws_size_stats *s, *best;
+	int i;
+
+	if (p->ws_size)
+		return p->ws_size;
+
+	best = NULL;
+	for (i = 0; i < N_AUTO_WS_SIZES; i++) {
+		s = &p->sizes[i];
+
+		if (!s->pages) {
+			if (!s->pending)
+				return s->size;
+			continue;
+		}
+
+		if (!best
+		    || s->entries * best->seconds > best->entries * s->seconds)
+			best = s;
+	}
+
+	return best ? best->size : DEFAULT_WS_SIZE;
+}
+
+/*
+ * Records the duration of a page of 'size' entries from 'start'. The
+ * number of entries is deduced from the collection size because the
+ * table of the page does not hold the skipped ones.
+ */
+static void
+measure_ws_size(struct bpph_pages *p, int size, int start, double seconds)
+{
+	struct ws_size_stats *s;
+	int n;
 
-	result = get_bpph_list_from_cache(key);
+	s = get_ws_size_stats(p, size);
+	if (!s)
+		return ;
 
-	if (result) {
-		date = get_last_creation_date(result);
+	n = p->total_size - start;
+	if (n > size)
+		n = size;
 
-		if (date) {
-			tmp = malloc(strlen(url)
-				     + strlen("&created_since_date=")
-				     + strlen(date)+1);
-			strcpy(tmp, url);
-			strcat(tmp, "&created_since_date=");
-			strcat(tmp, date);
+	if (n > 0) {
+		s->pages++;
+		s->entries += n;
+		s->seconds += seconds;
+	}
+}
 
-			free(url);
-			url = tmp;
+static void retrieve_bpph_pages(int worker, void *data)
+{
+	struct bpph_pages *p;
+	struct bpph_table *page, *rows, **all_rows, **pages;
+	struct ws_size_stats *s;
+	char *url, *body, *next_link, *retrieved;
+	double seconds;
+	int i, size, start, last;
+
+	p = data;
+
+	for (;;) {
+		pthread_mutex_lock(&p->mutex);
+
+		/* the retrieval is thrown away once a page failed */
+		if (p->failed || p->start >= p->total_size) {
+			pthread_mutex_unlock(&p->mutex);
+			return ;
+		}
 
-			free(date);
+		if (p->n == p->capacity) {
+			pages = realloc(p->pages,
+					2 * p->capacity
+					* sizeof(struct bpph_table *));
+			if (pages)
+				p->pages = pages;
+
+			retrieved = realloc(p->retrieved, 2 * p->capacity);
+			if (retrieved)
+				p->retrieved = retrieved;
+
+			if (!pages || !retrieved) {
+				log_err(_("Failed to retrieve %s"), p->query);
+				p->failed = 1;
+				pthread_mutex_unlock(&p->mutex);
+				return ;
+			}
+			p->capacity *= 2;
 		}
+		i = p->n++;
+		p->pages[i] = NULL;
+		p->retrieved[i] = 0;
+
+		size = choose_ws_size(p);
+		s = get_ws_size_stats(p, size);
+		if (s)
+			s->pending++;
+
+		start = p->start;
+		p->start += size;
+		last = p->start >= p->total_size;
+
+		pthread_mutex_unlock(&p->mutex);
+
+		url = create_bpph_page_query(p->query, size, start);
+		page = get_bpph_page(url,
+				     &body,
+				     &next_link,
+				     NULL,
+				     &seconds);
+
+		pthread_mutex_lock(&p->mutex);
+
+		if (s)
+			s->pending--;
+
+		if (page) {
+			measure_ws_size(p, size, start, seconds);
+
+			if (last && next_link)
+				p->next_link = strdup(next_link);
+		} else {
+			log_err(_("Failed to retrieve %s"), url);
+			p->failed = 1;
+		}
+
+		p->pages[i] = page;
+		p->retrieved[i] = 1;
+
+		while (p->next < p->n && p->retrieved[p->next]) {
+			rows = merge_bpph_table(p->list, p->pages[p->next]);
+			if (rows) {
+				all_rows = (struct bpph_table **)
+					vector_push((void **)p->rows, rows);
+				if (all_rows) {
+					p->rows = all_rows;
+				} else {
+					bpph_table_free(rows);
+					p->failed = 1;
+				}
+			}
+			p->next++;
+		}
+
+		free(url);
+		free(body);
+
+		if (p->notifying) {
+			pthread_mutex_unlock(&p->mutex);
+			continue;
+		}
+
+		/*
+		 * The callback may block, the other workers go on while
+		 * this one notifies the entries merged meanwhile.
+		 */
+		p->notifying = 1;
+		while (p->next_rows < vector_length((void **)p->rows)) {
+			rows = p->rows[p->next_rows++];
+			pthread_mutex_unlock(&p->mutex);
+
+			p->list->cbk(rows, p->list->data);
+
+			pthread_mutex_lock(&p->mutex);
+		}
+		p->notifying = 0;
+
+		pthread_mutex_unlock(&p->mutex);
 	}
+}
+
+struct bpph_table *get_bpph_list(const char *archive_url,
+				 const char *pkg_status,
+				 int ws_size,
+				 void (*cbk)(struct bpph_table *, void *),
+				 void *data)
+{
+	char *query, *url, *key, *tmp, *body, *next_link, *bin, *cached;
+	struct bpph_table *table, *page;
+	struct bpph_list l;
+	struct bpph_pages p;
+	char date[ISO8601_TIME_SIZE];
+	size_t size, cached_size;
+	long synced, today;
+	double seconds;
+	int ok, full, i, first_size;
+
+	query = create_query_get_bpph(archive_url);
+
+	key = get_bpph_list_cache_key(archive_url);
+
+	table = bpph_table_new();
+
+	l.all = table;
+	l.selected = pkg_status ? bpph_table_new() : table;
+	l.status = pkg_status;
+	l.cbk = cbk;
+	l.data = data;
+
+	add_bpph_table(&l,
+		       get_bpph_table_from_cache(key,
+						 &cached,
+						 &cached_size,
+						 &synced));
+
+	/*
+	 * Only the new entries are retrieved except periodically where
+	 * all of them are retrieved for updating the status of the
+	 * cached ones.
+	 */
+	today = time(NULL) / DAY_SECONDS;
+	full = today - synced >= BPPH_RESYNC_DAYS;
+
+	if (!full && get_last_creation_date(table, date)) {
+		tmp = malloc(strlen(query)
+			     + strlen("&created_since_date=")
+			     + strlen(date)+1);
+		strcpy(tmp, query);
+		strcat(tmp, "&created_since_date=");
+		strcat(tmp, date);
+
+		free(query);
+		query = tmp;
+	}
+
+	memset(&p, 0, sizeof(struct bpph_pages));
+	p.query = query;
+	p.ws_size = ws_size == WS_SIZE_AUTO ? 0 : get_ws_size(ws_size);
+	for (i = 0; i < N_AUTO_WS_SIZES; i++)
+		p.sizes[i].size = AUTO_WS_SIZES[i];
+	p.list = &l;
+	pthread_mutex_init(&p.mutex, NULL);
 
 	ok = 1;
+
+	first_size = choose_ws_size(&p);
+	url = create_bpph_page_query(query, first_size, 0);
+	page = get_bpph_page(url, &body, &next_link, &p.total_size, &seconds);
+	free(url);
+	url = NULL;
+
+	if (page) {
+		measure_ws_size(&p, first_size, 0, seconds);
+		add_bpph_table(&l, page);
+
+		/*
+		 * When the first page gives the size of the collection,
+		 * the other pages are retrieved concurrently from their
+		 * offsets. Otherwise, or if the collection has grown
+		 * meanwhile, the remaining pages are retrieved by
+		 * following the links.
+		 */
+		if (next_link && p.total_size > first_size) {
+			p.start = first_size;
+			p.capacity = 16;
+			p.pages = malloc(p.capacity
+					 * sizeof(struct bpph_table *));
+			p.retrieved = malloc(p.capacity);
+			p.rows = (struct bpph_table **)vector_new(16);
+
+			if (p.pages && p.retrieved) {
+				workers_run(max_jobs,
+					    max_jobs,
+					    retrieve_bpph_pages,
+					    &p);
+			} else {
+				log_err(_("Failed to retrieve %s"), p.query);
+				p.failed = 1;
+			}
+
+			free(p.pages);
+			free(p.retrieved);
+			vector_free((void **)p.rows);
+
+			if (p.failed) {
+				free(p.next_link);
+				ok = 0;
+			} else {
+				url = p.next_link;
+			}
+		} else if (next_link) {
+			url = strdup(next_link);
+		}
+	} else {
+		ok = 0;
+	}
+	free(body);
+
 	while (url) {
-		o = get_json_object(url);
+		page = get_bpph_page(url, &body, &next_link, NULL, &seconds);
 		free(url);
 		url = NULL;
 
-		if (!o) {
+		if (!page) {
+			free(body);
 			ok = 0;
 			break;
 		}
 
-		result = bpph_list_append_list(result,
-					       json_object_to_bpph_list(o));
-
-		json_object_object_get_ex(o, "next_collection_link", &o_next);
+		if (next_link)
+			url = strdup(next_link);
 
-		if (o_next)
-			url = strdup(json_object_get_string(o_next));
+		free(body);
 
-		json_object_put(o);
+		add_bpph_table(&l, page);
 	}
 
+	pthread_mutex_lock(&bpph_timings_mutex);
+	bpph_timings.ws_size = choose_ws_size(&p);
+	bpph_timings.auto_ws_size = !p.ws_size;
+	pthread_mutex_unlock(&bpph_timings_mutex);
+
+	for (i = 0; i < N_AUTO_WS_SIZES; i++)
+		if (!p.ws_size && p.sizes[i].pages)
+			log_debug(_("page size %d: %d pages, %.1f entries/s"),
+				  p.sizes[i].size,
+				  p.sizes[i].pages,
+				  p.sizes[i].entries / p.sizes[i].seconds);
+
+	pthread_mutex_destroy(&p.mutex);
+	free(query);
+
 	if (ok) {
-		bpph_json = bpph_list_to_json(result);
-		fcache_put(key, json_object_to_json_string(bpph_json));
-		json_object_put(bpph_json);
+		if (full)
+			synced = today;
+
+		bin = bpph_table_to_bin(table, synced, &size);
+		put_bin(key, bin, size, cached, cached_size);
 	}
 
+	free(cached);
 	free(key);
 
-	return result;
+	if (l.selected != table)
+		bpph_table_free(table);
+
+	if (!l.selected->length) {
+		bpph_table_free(l.selected);
+		return NULL;
+	}
+
+	return l.selected;
 }
 
 int get_download_count(const char *archive_url)
@@ -247,118 +897,654 @@ int get_download_count(const char *archive_url)
 	return result;
 }
 
+char **get_ppa_names(const char *owner)
+{
+	char **names, **page, **name, **tmp, *url, *content, *next;
+
+	names = (char **)vector_new(0);
+	if (!names)
+		return NULL;
+
+	url = get_ppas_url(owner);
+
+	while (url) {
+		content = get_url_content(url, 0);
+		if (!content) {
+			log_err(_("Failed to retrieve %s"), url);
+			goto on_error;
+		}
+
+		page = lp_parse_ppa_names(content, &next);
+		if (!page) {
+			log_err(_("Failed to parse %s"), url);
+			free(content);
+			goto on_error;
+		}
+
+		for (name = page; *name; name++) {
+			tmp = (char **)vector_push((void **)names, *name);
+			if (!tmp)
+				break;
+			names = tmp;
+		}
+
+		if (*name) {
+			log_err(_("Failed to add the PPAs of %s"), url);
+			for (; *name; name++)
+				free(*name);
+			vector_free((void **)page);
+			free(content);
+			goto on_error;
+		}
+		vector_free((void **)page);
+
+		free(url);
+		url = next ? strdup(next) : NULL;
+		free(content);
+	}
+
+	return names;
+
+ on_error:
+	free(url);
+	for (name = names; *name; name++)
+		free(*name);
+	vector_free((void **)names);
+
+	return NULL;
+}
+
+/*
+ * The distro series and distro arch series almost never change, they
+ * are kept in a snapshot stored in the file cache and loaded in one
+ * read on their first use. Without it, the snapshot installed in the
+ * data directory seeds the cache. A stale snapshot is used as is while
+ * its objects are retrieved again in the background, the retrieved
+ * ones then replace them and the snapshot is stored again.
+ */
+static const char *DISTRO_SNAPSHOT_KEY = "/distro_snapshot";
+
+/* Age after which the objects of the snapshot are retrieved again. */
+static const int DISTRO_SNAPSHOT_MAX_AGE = 30 * 24 * 60 * 60;
+
+/* Delay before retrying a refresh of the snapshot which failed. */
+static const int DISTRO_SNAPSHOT_RETRY_DELAY = 24 * 60 * 60;
+
+struct distro_refresh {
+	/* copies of the URLs of the stale objects */
+	char **arch_series_urls;
+	char **series_urls;
+	/* retrieved objects, NULL if one of them failed */
+	struct distro_snapshot *fresh;
+	/* 1 once the retrieval is over, protected by distros_mutex */
+	int done;
+};
+
+struct distros {
+	/* objects of the stored snapshot then of the run, owned */
+	struct distro_snapshot *snapshot;
+	/* objects indexed by URL */
+	struct hashmap *arch_series;
+	struct hashmap *series;
+	/* number of objects retrieved again by the refresh, the first ones */
+	int n_refreshed_arch_series;
+	int n_refreshed_series;
+	/* 1 if the snapshot has to be stored again */
+	int changed;
+	int refreshing;
+	/* time before which a stale snapshot is not refreshed again */
+	time_t next_refresh;
+	pthread_t refresh_thread;
+	struct distro_refresh refresh;
+};
+
+static struct distros distros;
+static pthread_once_t distros_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t distros_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* 'seeded' is set to 1 if the snapshot is the one of the data directory. */
+static struct distro_snapshot *load_distro_snapshot(int *seeded)
+{
+	struct distro_snapshot *snapshot;
+	const char *path;
+	char *content;
+	size_t size;
+	long len;
+
+	*seeded = 0;
+
+	content = fcache_get_data(DISTRO_SNAPSHOT_KEY, &size);
+	if (!content) {
+		path = PACKAGE_DATA_DIR "/distro_snapshot";
+		len = file_get_size(path);
+		if (len <= 0)
+			return NULL;
+		size = len;
+		content = file_get_content(path);
+		if (!content)
+			return NULL;
+		*seeded = 1;
+	}
+
+	snapshot = bin_to_distro_snapshot(content, size);
+	free(content);
+
+	if (!snapshot)
+		log_debug(_("invalid distro snapshot"));
+
+	return snapshot;
+}
+
+/* Returns NULL if the copy cannot be allocated. */
+static char **copy_urls(char **urls)
+{
+	char **copy;
+
+	copy = (char **)vector_new(vector_length((void **)urls));
+	if (!copy)
+		return NULL;
+
+	/* the capacity is reserved, the vector does not grow */
+	for (; *urls; urls++)
+		copy = (char **)vector_push((void **)copy, strdup(*urls));
+
+	return copy;
+}
+
+static void free_urls(char **urls)
+{
+	char **url;
+
+	for (url = urls; url && *url; url++)
+		free(*url);
+	vector_free((void **)urls);
+}
+
+static void *refresh_distros(void *data)
+{
+	struct distro_refresh *r;
+	struct distro_snapshot *fresh;
+	struct distro_arch_series *a;
+	struct distro_series *d;
+	char *content, **url;
+
+	r = data;
+	fresh = distro_snapshot_new(time(NULL));
+	if (!fresh)
+		goto out;
+
+	for (url = r->arch_series_urls; *url; url++) {
+		content = get_url_content(*url, 0);
+		a = content ? lp_parse_distro_arch_series(content) : NULL;
+		free(content);
+		if (!a)
+			goto on_error;
+		if (distro_snapshot_add_arch_series(fresh, *url, a)) {
+			distro_arch_series_free(a);
+			goto on_error;
+		}
+	}
+
+	for (url = r->series_urls; *url; url++) {
+		content = get_url_content(*url, 0);
+		d = content ? lp_parse_distro_series(content) : NULL;
+		free(content);
+		if (!d)
+			goto on_error;
+		if (distro_snapshot_add_series(fresh, *url, d)) {
+			distro_series_free(d);
+			goto on_error;
+		}
+	}
+
+	goto out;
+
+ on_error:
+	log_debug(_("failed to refresh the distro snapshot with %s"), *url);
+	distro_snapshot_free(fresh, 1);
+	fresh = NULL;
+
+ out:
+	pthread_mutex_lock(&distros_mutex);
+	r->fresh = fresh;
+	r->done = 1;
+	pthread_mutex_unlock(&distros_mutex);
+
+	return NULL;
+}
+
+static void index_distros(const struct distro_snapshot *s,
+			  struct hashmap *arch_series,
+			  struct hashmap *series)
+{
+	int i;
+
+	for (i = 0; s->arch_series_urls[i]; i++)
+		hashmap_put(arch_series,
+			    s->arch_series_urls[i],
+			    s->arch_series[i]);
+	for (i = 0; s->series_urls[i]; i++)
+		hashmap_put(series, s->series_urls[i], s->series[i]);
+}
+
+/* Starts the retrieval of the objects of a stale snapshot. */
+static void start_distros_refresh()
+{
+	struct distro_snapshot *s;
+	time_t now;
+
+	s = distros.snapshot;
+	now = time(NULL);
+
+	if (distros.refreshing
+	    || now - s->date < DISTRO_SNAPSHOT_MAX_AGE
+	    || now < distros.next_refresh)
+		return ;
+
+	pthread_mutex_lock(&distros_mutex);
+	distros.n_refreshed_arch_series
+		= vector_length((void **)s->arch_series);
+	distros.n_refreshed_series = vector_length((void **)s->series);
+	if (distros.n_refreshed_arch_series || distros.n_refreshed_series) {
+		distros.refresh.arch_series_urls
+			= copy_urls(s->arch_series_urls);
+		distros.refresh.series_urls = copy_urls(s->series_urls);
+	}
+	pthread_mutex_unlock(&distros_mutex);
+
+	if (!distros.n_refreshed_arch_series && !distros.n_refreshed_series)
+		return ;
+
+	distros.refresh.fresh = NULL;
+	distros.refresh.done = 0;
+
+	if (!distros.refresh.arch_series_urls
+	    || !distros.refresh.series_urls
+	    || pthread_create(&distros.refresh_thread,
+			   NULL,
+			   refresh_distros,
+			   &distros.refresh)) {
+		free_urls(distros.refresh.arch_series_urls);
+		free_urls(distros.refresh.series_urls);
+		distros.next_refresh = now + DISTRO_SNAPSHOT_RETRY_DELAY;
+	} else {
+		distros.refreshing = 1;
+	}
+}
+
+static void init_distros()
+{
+	struct distro_snapshot *s;
+	int seeded;
+
+	s = load_distro_snapshot(&seeded);
+	if (!s)
+		s = distro_snapshot_new(time(NULL));
+
+	distros.snapshot = s;
+	distros.arch_series = hashmap_new();
+	distros.series = hashmap_new();
+
+	/* without a snapshot, the objects are not kept */
+	if (!s)
+		return ;
+
+	index_distros(s, distros.arch_series, distros.series);
+
+	/* the seed is copied into the file cache */
+	distros.changed = seeded;
+
+	start_distros_refresh();
+}
+
+/* Returns the object of a URL from the snapshot, or NULL. */
+static void *get_distro(struct hashmap *map, const char *url)
+{
+	void *distro;
+
+	pthread_mutex_lock(&distros_mutex);
+	distro = hashmap_get(map, url);
+	pthread_mutex_unlock(&distros_mutex);
+
+	if (distro)
+		log_debug(_("distro snapshot hit %s"), url);
+
+	return distro;
+}
+
 const struct distro_arch_series *get_distro_arch_series(const char *url)
 {
-	json_object *obj;
-	const struct distro_arch_series *distro;
+	struct distro_arch_series *distro, *d;
+	struct distro_snapshot *s;
 	char *content;
+	int n;
+
+	pthread_once(&distros_once, init_distros);
 
-	distro = cache_get(url);
+	distro = get_distro(distros.arch_series, url);
 	if (distro)
-		return (struct distro_arch_series *)distro;
+		return distro;
 
 	content = get_url_content(url, 1);
 
 	if (!content)
 		return NULL;
 
-	obj = json_tokener_parse(content);
+	distro = lp_parse_distro_arch_series(content);
 
 	free(content);
 
-	if (!obj)
+	if (!distro)
 		return NULL;
 
-	distro = json_object_to_distro_arch_series(obj);
-
-	json_object_put(obj);
-
-	cache_put(url, distro, (void (*)(void *))&distro_arch_series_free);
+	pthread_mutex_lock(&distros_mutex);
+	/* retrieved concurrently by another thread */
+	d = hashmap_get(distros.arch_series, url);
+	s = distros.snapshot;
+	if (d) {
+		distro_arch_series_free(distro);
+		distro = d;
+	} else if (!s || distro_snapshot_add_arch_series(s, url, distro)) {
+		log_err(_("Failed to keep %s"), url);
+		distro_arch_series_free(distro);
+		distro = NULL;
+	} else {
+		n = vector_length((void **)s->arch_series_urls);
+		hashmap_put(distros.arch_series,
+			    s->arch_series_urls[n - 1],
+			    distro);
+		distros.changed = 1;
+	}
+	pthread_mutex_unlock(&distros_mutex);
 
 	return distro;
 }
 
 const struct distro_series *get_distro_series(const char *url)
 {
-	json_object *obj;
-	const struct distro_series *distro;
+	struct distro_series *distro, *d;
+	struct distro_snapshot *s;
 	char *content;
+	int n;
+
+	pthread_once(&distros_once, init_distros);
 
-	distro = cache_get(url);
+	distro = get_distro(distros.series, url);
 	if (distro)
-		return (struct distro_series *)distro;
+		return distro;
 
 	content = get_url_content(url, 1);
 
 	if (!content)
 		return NULL;
 
-	obj = json_tokener_parse(content);
+	distro = lp_parse_distro_series(content);
 
 	free(content);
 
-	if (!obj)
+	if (!distro)
 		return NULL;
 
-	distro = json_object_to_distro_series(obj);
+	pthread_mutex_lock(&distros_mutex);
+	d = hashmap_get(distros.series, url);
+	s = distros.snapshot;
+	if (d) {
+		distro_series_free(distro);
+		distro = d;
+	} else if (!s || distro_snapshot_add_series(s, url, distro)) {
+		log_err(_("Failed to keep %s"), url);
+		distro_series_free(distro);
+		distro = NULL;
+	} else {
+		n = vector_length((void **)s->series_urls);
+		hashmap_put(distros.series, s->series_urls[n - 1], distro);
+		distros.changed = 1;
+	}
+	pthread_mutex_unlock(&distros_mutex);
 
-	json_object_put(obj);
+	return distro;
+}
 
-	cache_put(url, distro, (void (*)(void *))&distro_series_free);
+/*
+ * Adds the objects of 'src' from the given indexes, they are shared.
+ * Returns -1 if they cannot all be added.
+ */
+static int add_distros(struct distro_snapshot *dst,
+		       const struct distro_snapshot *src,
+		       int arch_series_start,
+		       int series_start)
+{
+	int i;
 
-	return distro;
+	for (i = arch_series_start; src->arch_series_urls[i]; i++)
+		if (distro_snapshot_add_arch_series(dst,
+						    src->arch_series_urls[i],
+						    src->arch_series[i]))
+			return -1;
+
+	for (i = series_start; src->series_urls[i]; i++)
+		if (distro_snapshot_add_series(dst,
+					       src->series_urls[i],
+					       src->series[i]))
+			return -1;
+
+	return 0;
 }
 
 /*
-  Convert ddts older than 4 weeks to the same JSON representation than
-  the LP one.  Newer ddts are not stored in the cache because the data
-  may change during following days. It avoids to miss downloads which
-  are not yet taken in consideration by LP.
+ * Replaces the refreshed objects of the snapshot by the retrieved ones,
+ * the objects added since the start of the refresh are kept. The
+ * snapshot is kept as is if the refresh failed.
+ *
+ * The replaced objects are released, it must not be called while the
+ * PPAs are processed.
  */
-static json_object *ddts_to_json_for_cache(struct daily_download_total **ddts)
+static void finish_distros_refresh()
 {
-	json_object *j_ddts;
-	struct daily_download_total *ddt;
-	char *date;
-	struct timeval *tv;
-	time_t t;
-	double d;
+	struct distro_snapshot *fresh, *old, *s;
+	struct hashmap *arch_series, *series;
+	int i;
+
+	pthread_join(distros.refresh_thread, NULL);
+	free_urls(distros.refresh.arch_series_urls);
+	free_urls(distros.refresh.series_urls);
+	distros.refreshing = 0;
+
+	fresh = distros.refresh.fresh;
+	distros.refresh.fresh = NULL;
+	old = distros.snapshot;
+
+	s = fresh ? distro_snapshot_new(fresh->date) : NULL;
+	if (s
+	    && (add_distros(s, fresh, 0, 0)
+		|| add_distros(s,
+			       old,
+			       distros.n_refreshed_arch_series,
+			       distros.n_refreshed_series))) {
+		distro_snapshot_free(s, 0);
+		s = NULL;
+	}
 
-	j_ddts = json_object_new_object();
+	if (!s) {
+		if (fresh)
+			log_err(_("Failed to refresh the distro snapshot"));
+		distro_snapshot_free(fresh, 1);
+		distros.next_refresh = time(NULL) + DISTRO_SNAPSHOT_RETRY_DELAY;
+		return ;
+	}
 
-	tv = malloc(sizeof(struct timeval));
-	gettimeofday(tv, NULL);
+	arch_series = hashmap_new();
+	series = hashmap_new();
+	index_distros(s, arch_series, series);
+
+	pthread_mutex_lock(&distros_mutex);
+	hashmap_free(distros.arch_series);
+	hashmap_free(distros.series);
+	distros.arch_series = arch_series;
+	distros.series = series;
+	distros.snapshot = s;
+	distros.changed = 1;
+	pthread_mutex_unlock(&distros_mutex);
+
+	for (i = 0; i < distros.n_refreshed_arch_series; i++)
+		distro_arch_series_free(old->arch_series[i]);
+	for (i = 0; i < distros.n_refreshed_series; i++)
+		distro_series_free(old->series[i]);
+	distro_snapshot_free(old, 0);
+	distro_snapshot_free(fresh, 0);
+}
 
-	while (ddts && *ddts) {
-		ddt = *ddts;
+/* Stores the snapshot if it holds new or refreshed objects. */
+static void store_distros()
+{
+	char *bin;
+	size_t size;
+
+	pthread_mutex_lock(&distros_mutex);
+	if (distros.changed) {
+		bin = distro_snapshot_to_bin(distros.snapshot, &size);
+		fcache_put_data(DISTRO_SNAPSHOT_KEY, bin, size);
+		free(bin);
+		distros.changed = 0;
+	}
+	pthread_mutex_unlock(&distros_mutex);
+}
+
+void lp_ws_refresh_distros()
+{
+	int done;
 
-		t = mktime(&(ddt->date));
+	pthread_once(&distros_once, init_distros);
 
-		d = difftime(tv->tv_sec, t);
+	if (!distros.snapshot)
+		return ;
 
-		if (d > 4 * 7 * 24 * 60 * 60) { /* older than 4 weeks */
-			date = tm_to_ISO8601_date(&ddt->date);
-			json_object_object_add(j_ddts,
-					       date,
-					       json_object_new_int(ddt->count));
-			free(date);
-		}
+	if (distros.refreshing) {
+		pthread_mutex_lock(&distros_mutex);
+		done = distros.refresh.done;
+		pthread_mutex_unlock(&distros_mutex);
+
+		if (done)
+			finish_distros_refresh();
+	}
+
+	store_distros();
+	start_distros_refresh();
+}
+
+void lp_ws_cleanup()
+{
+	if (!distros.arch_series)
+		return ;
+
+	if (distros.refreshing)
+		finish_distros_refresh();
+
+	if (distros.snapshot)
+		store_distros();
+
+	hashmap_free(distros.arch_series);
+	hashmap_free(distros.series);
+	distro_snapshot_free(distros.snapshot, 1);
+
+	memset(&distros, 0, sizeof(struct distros));
+}
+
+/* Returns the number of downloads of the 30 days before 'today'. */
+static int get_velocity(struct daily_download_total **ddts, long today)
+{
+	struct tm *tm;
+	int n;
+
+	n = 0;
+
+	while (ddts && *ddts) {
+		tm = &(*ddts)->date;
+
+		if (date_to_days(tm->tm_year + 1900,
+				 tm->tm_mon + 1,
+				 tm->tm_mday) > today - 30)
+			n += (*ddts)->count;
 
 		ddts++;
 	}
 
-	free(tv);
+	return n;
+}
 
-	return j_ddts;
+/*
+ * Returns the cached ddts of 'key' and stores their state in 'state',
+ * or returns NULL if there is no valid entry. When the entry is in the
+ * binary format, its content is stored in 'bin' for detecting later
+ * whether it changed, else 'bin' is set to NULL.
+ */
+static struct daily_download_total **
+get_ddts_from_cache(const char *key,
+		    char **bin,
+		    size_t *size,
+		    struct ddts_state *state)
+{
+	char *content;
+	struct daily_download_total **ddts;
+
+	*bin = NULL;
+	memset(state, 0, sizeof(struct ddts_state));
+
+	content = fcache_get_data(key, size);
+	if (!content)
+		return NULL;
+
+	if (is_lp_bin(content, *size)) {
+		ddts = bin_to_ddts(content, *size, state);
+		*bin = content;
+	} else { /* JSON entry of older releases */
+		ddts = lp_parse_daily_download_totals(content);
+		free(content);
+
+		/* its ddts were final when it was written */
+		state->finalized = ddts_get_last_date(ddts) / DAY_SECONDS;
+	}
+
+	return ddts;
+}
+
+int get_ddts_state(const char *binary_url, struct ddts_state *state)
+{
+	char *key, *content;
+	size_t size;
+	int ret;
+
+	key = get_ddts_list_cache_key(binary_url);
+	content = fcache_get_data(key, &size);
+
+	if (content && is_lp_bin(content, size))
+		ret = bin_to_ddts_state(content, size, state);
+	else
+		ret = -1;
+
+	free(content);
+	free(key);
+
+	return ret;
+}
+
+void ddts_set_settling_days(int days)
+{
+	settling_days = days;
+}
+
+void lp_ws_set_jobs(int jobs)
+{
+	max_jobs = jobs;
 }
 
 char *create_ddts_query(const char *binary_url, time_t st, time_t et)
 {
 	char *q;
-	char *sdate, *edate;
+	char sdate[ISO8601_DATE_SIZE], edate[ISO8601_DATE_SIZE];
 
 	if (st) {
-		sdate = time_to_ISO8601_date(&st);
+		time_to_ISO8601_date_r(st, sdate);
 
 		q = malloc(strlen(binary_url)
 			   + strlen(QUERY_GET_DAILY_DOWNLOAD_TOTALS)
@@ -371,13 +1557,10 @@ char *create_ddts_query(const char *binary_url, time_t st, time_t et)
 		strcat(q, sdate);
 
 		if (et > 0) {
-			edate = time_to_ISO8601_date(&et);
+			time_to_ISO8601_date_r(et, edate);
 			strcat(q, "&end_date=");
 			strcat(q, edate);
-			free(edate);
 		}
-
-		free(sdate);
 	} else {
 		q = malloc(strlen(binary_url)
 			   + strlen(QUERY_GET_DAILY_DOWNLOAD_TOTALS)
@@ -389,107 +1572,322 @@ char *create_ddts_query(const char *binary_url, time_t st, time_t et)
 	return q;
 }
 
-static struct daily_download_total **retrieve_ddts(const char *binary_url,
-						   time_t date_since)
+/* Returns the daily download totals of a getDailyDownloadTotals query. */
+static struct daily_download_total **get_ddts(const char *url)
 {
+	char *body;
+	struct daily_download_total **ddts;
+
+	body = get_url_content(url, 0);
+
+	if (!body)
+		return NULL;
+
+	ddts = lp_parse_daily_download_totals(body);
+
+	free(body);
+
+	return ddts;
+}
+
+/* Range of days [first, last] of a getDailyDownloadTotals query. */
+struct ddts_range {
+	long first;
+	long last;
+	/* NULL if the query failed */
+	struct daily_download_total **ddts;
+};
+
+struct recovery {
+	const char *binary_url;
+	struct ddts_range *ranges;
+};
+
+static void retrieve_range(int i, void *data)
+{
+	struct recovery *rec;
+	struct ddts_range *r;
 	char *url;
-	json_object *json;
-	struct daily_download_total **ddts, **tmp;
-	time_t crt;
 
-	url = create_ddts_query(binary_url, date_since, 0);
-	json = get_json_object(url);
+	rec = data;
+	r = &rec->ranges[i];
+
+	url = create_ddts_query(rec->binary_url,
+				r->first * DAY_SECONDS,
+				r->last * DAY_SECONDS);
+	r->ddts = get_ddts(url);
 	free(url);
+}
 
-	if (json) {
-		ddts = json_object_to_daily_download_totals(json);
-		json_object_put(json);
-	} else {
-		crt = time(NULL);
-		ddts = NULL;
+static int ddts_range_cmp(const void *o1, const void *o2)
+{
+	const struct ddts_range *r1, *r2;
 
-		while (date_since < crt) {
-			url = create_ddts_query(binary_url,
-						date_since,
-						date_since);
-			json = get_json_object(url);
-			free(url);
+	r1 = o1;
+	r2 = o2;
 
-			if (!json)
-				break;
+	if (r1->first != r2->first)
+		return r1->first < r2->first ? -1 : 1;
 
-			tmp = json_object_to_daily_download_totals(json);
-			json_object_put(json);
-			ddts = ddts_merge(ddts, tmp);
-			free(tmp);
+	return 0;
+}
 
-			date_since = date_since + 24 * 60 * 60; /* +1 day */
+static void
+split_range(struct ddts_range *ranges, int *n, long first, long last)
+{
+	long middle;
 
-			url = create_ddts_query(binary_url, date_since, 0);
-			json = get_json_object(url);
-			free(url);
+	middle = first + (last - first) / 2;
 
-			if (json) {
-				tmp = json_object_to_daily_download_totals
-					(json);
-				json_object_put(json);
-				ddts = ddts_merge(ddts, tmp);
-				free(tmp);
-				break;
+	ranges[*n].first = first;
+	ranges[*n].last = middle;
+	ranges[*n].ddts = NULL;
+	(*n)++;
+
+	ranges[*n].first = middle + 1;
+	ranges[*n].last = last;
+	ranges[*n].ddts = NULL;
+	(*n)++;
+}
+
+static void log_day_failure(const char *binary_url, long day)
+{
+	char date[ISO8601_DATE_SIZE];
+
+	time_to_ISO8601_date_r(day * DAY_SECONDS, date);
+	log_err(_("Failed to retrieve the download totals of %s for %s"),
+		binary_url,
+		date);
+}
+
+/*
+ * Retrieves the ddts of the days [first, last] whose single query
+ * failed. The failed ranges are split in two halves retrieved
+ * concurrently, until they succeed or are reduced to a single day.
+ * 'complete' is set to 0 if some days cannot be retrieved.
+ */
+static struct daily_download_total **
+recover_ddts(const char *binary_url, long first, long last, int *complete)
+{
+	struct recovery rec;
+	struct ddts_range *done, *next, *r;
+	struct daily_download_total **ddts, **merged;
+	int n, n_done, n_next, i, jobs;
+
+	if (first >= last) {
+		log_day_failure(binary_url, first);
+		*complete = 0;
+		return NULL;
+	}
+
+	/* each round at most doubles the ranges */
+	done = malloc((last - first + 1) * sizeof(struct ddts_range));
+	n_done = 0;
+
+	rec.binary_url = binary_url;
+	rec.ranges = malloc(2 * sizeof(struct ddts_range));
+
+	if (!done || !rec.ranges) {
+		log_err(_("Failed to recover the download totals of %s"),
+			binary_url);
+		free(done);
+		free(rec.ranges);
+		*complete = 0;
+		return NULL;
+	}
+
+	n = 0;
+	split_range(rec.ranges, &n, first, last);
+
+	while (n) {
+		jobs = n < max_jobs ? n : max_jobs;
+		workers_run(n, jobs, retrieve_range, &rec);
+
+		/* without the next round, the failed ranges are given up */
+		next = malloc(2 * n * sizeof(struct ddts_range));
+		n_next = 0;
+
+		if (!next) {
+			log_err(_("Failed to recover the download totals "
+				  "of %s"),
+				binary_url);
+			*complete = 0;
+		}
+
+		for (i = 0; i < n; i++) {
+			r = &rec.ranges[i];
+
+			if (r->ddts) {
+				done[n_done++] = *r;
+			} else if (!next) {
+				continue;
+			} else if (r->first < r->last) {
+				split_range(next, &n_next, r->first, r->last);
+			} else {
+				log_day_failure(binary_url, r->first);
+				*complete = 0;
 			}
 		}
+
+		free(rec.ranges);
+		rec.ranges = next;
+		n = n_next;
+	}
+	free(rec.ranges);
+
+	qsort(done, n_done, sizeof(struct ddts_range), ddts_range_cmp);
+
+	ddts = NULL;
+	for (i = 0; i < n_done; i++) {
+		merged = ddts_merge(ddts, done[i].ddts);
+		daily_download_total_list_free(done[i].ddts);
+
+		if (!merged) {
+			log_err(_("Failed to merge the download totals of %s"),
+				binary_url);
+			*complete = 0;
+			continue;
+		}
+
+		daily_download_total_list_free(ddts);
+		ddts = merged;
 	}
+	free(done);
 
 	return ddts;
 }
 
+/*
+ * Retrieves the ddts from 'date_since'. 'complete' is set to 0 if some
+ * days cannot be retrieved.
+ */
+static struct daily_download_total **retrieve_ddts(const char *binary_url,
+						   time_t date_since,
+						   int *complete)
+{
+	char *url;
+	struct daily_download_total **ddts;
+
+	url = create_ddts_query(binary_url, date_since, 0);
+	ddts = get_ddts(url);
+	free(url);
+
+	*complete = 1;
+
+	if (!ddts)
+		ddts = recover_ddts(binary_url,
+				    date_since / DAY_SECONDS,
+				    time(NULL) / DAY_SECONDS,
+				    complete);
+
+	return ddts;
+}
+
+/*
+ * The cache entry of a binary holds all its ddts and its finalized
+ * day: the totals up to this day are final and are not retrieved
+ * again. The day advances to the last day before the settling window
+ * when all the totals since the previous one have been retrieved. Once
+ * it reaches the day the binary is frozen, nothing is retrieved
+ * anymore.
+ *
+ * The entry also holds the velocity of the binary and the delay before
+ * its next retrieval, doubled each time no new download is found.
+ */
 struct daily_download_total **get_daily_download_totals(const char *binary_url,
-							time_t date_created)
+							time_t date_created,
+							time_t date_frozen,
+							int refresh)
 {
-	char *key, *content;
-	json_object *j_ddts, *json;
+	char *key, *bin, *cached;
+	size_t size, cached_size;
 	struct daily_download_total **retrieved_ddts = NULL;
 	struct daily_download_total **cached_ddts;
 	struct daily_download_total **ddts;
-	time_t last_t;
+	struct ddts_state state;
+	long today;
+	time_t now;
+	int complete, n_new;
 
 	key = get_ddts_list_cache_key(binary_url);
 
-	content = fcache_get(key);
-	if (content) {
-		json = json_tokener_parse(content);
-		free(content);
-	} else {
-		json = NULL;
+	cached_ddts = get_ddts_from_cache(key, &cached, &cached_size, &state);
+
+	/*
+	 * Frozen binary: all its downloads happened before its final day,
+	 * the cached totals are complete.
+	 */
+	if (cached_ddts && date_frozen > 0 && state.finalized > 0
+	    && state.finalized >= date_frozen / DAY_SECONDS) {
+		log_debug(_("frozen download totals %s"), key);
+		refresh = 0;
 	}
 
-	if (json) {
-		cached_ddts = json_object_to_daily_download_totals(json);
-		json_object_put(json);
-		last_t = ddts_get_last_date(cached_ddts);
-	} else {
-		last_t = 0;
-		cached_ddts = NULL;
+	if (cached_ddts && !refresh) {
+		free(cached);
+		free(key);
+		return cached_ddts;
 	}
 
-	if (last_t > 0)
-		retrieved_ddts = retrieve_ddts(binary_url, last_t);
+	now = time(NULL);
+	today = now / DAY_SECONDS;
+
+	if (state.finalized <= 0)
+		retrieved_ddts = retrieve_ddts(binary_url,
+					       date_created,
+					       &complete);
+	else if (state.finalized < today)
+		retrieved_ddts = retrieve_ddts(binary_url,
+					       (state.finalized + 1)
+					       * DAY_SECONDS,
+					       &complete);
 	else
-		retrieved_ddts = retrieve_ddts(binary_url, date_created);
+		complete = 1;
 
 	ddts = ddts_merge(cached_ddts, retrieved_ddts);
+	if (!ddts) {
+		log_err(_("Failed to merge the download totals of %s"),
+			binary_url);
+		free(cached);
+		free(key);
+		daily_download_total_list_free(cached_ddts);
+		daily_download_total_list_free(retrieved_ddts);
+		return NULL;
+	}
 
-	if (ddts) {
-		j_ddts = ddts_to_json_for_cache(ddts);
-		fcache_put(key, json_object_get_string(j_ddts));
-		json_object_put(j_ddts);
+	if (complete && state.finalized < today - settling_days)
+		state.finalized = today - settling_days;
+
+	/*
+	 * The refresh metadata is only updated for the scheduler, else
+	 * the entry would be rewritten by each run.
+	 */
+	if (complete && scheduler_is_enabled()) {
+		n_new = ddts_get_count(ddts);
+		if (cached_ddts)
+			n_new -= ddts_get_count(cached_ddts);
+
+		if (n_new)
+			state.interval = 0;
+		else if (state.interval < REFRESH_MIN_INTERVAL)
+			state.interval = REFRESH_MIN_INTERVAL;
+		else if (state.interval < REFRESH_MAX_INTERVAL / 2)
+			state.interval *= 2;
+		else
+			state.interval = REFRESH_MAX_INTERVAL;
+
+		state.refreshed = now;
+		state.velocity = get_velocity(ddts, today);
 	}
+
+	bin = ddts_to_bin(ddts, &state, &size);
+	put_bin(key, bin, size, cached, cached_size);
+
+	free(cached);
 	free(key);
 
-	if (ddts != cached_ddts)
-		daily_download_total_list_free(cached_ddts);
+	daily_download_total_list_free(cached_ddts);
 	daily_download_total_list_free(retrieved_ddts);
 
 	return ddts;
 }
-
@@ -22,21 +22,95 @@
 
 #include "lp.h"
 
+/* ws_size value choosing the page size from the measured throughput */
+#define WS_SIZE_AUTO 0
+
 /*
- * 'ws_size': size of the reply array of the getPublishedBinaries request.
+ * 'package_status': if not NULL, only the entries of this status are
+ * returned. The filter is applied locally, the cache holds all the
+ * entries of the archive.
+ * 'ws_size': size of the reply array of the getPublishedBinaries request,
+ * or WS_SIZE_AUTO.
+ * 'cbk': if not NULL, called with a table of the entries added to the
+ * result as soon as they are loaded from the cache or parsed from a LP
+ * reply. The callback owns the table.
+ *
+ * Returns NULL if no entry has been retrieved.
  */
-struct bpph **
-get_bpph_list(const char *archive_url, const char *package_status, int ws_size);
+struct bpph_table *
+get_bpph_list(const char *archive_url,
+	      const char *package_status,
+	      int ws_size,
+	      void (*cbk)(struct bpph_table *rows, void *data),
+	      void *data);
+
+/* Statistics of the retrieval of the getPublishedBinaries pages. */
+struct bpph_timings {
+	int pages;
+	long entries;
+	size_t bytes;
+	/* cumulated duration of the requests */
+	double seconds;
+	/* page size used, or chosen by the automatic mode */
+	int ws_size;
+	int auto_ws_size;
+};
+
+void get_bpph_timings(struct bpph_timings *timings);
 
 int get_download_count(const char *archive_url);
 
+/*
+ * Returns the vector of the names of the PPAs of an owner, or NULL if
+ * they cannot be retrieved. The list is never cached.
+ */
+char **get_ppa_names(const char *owner);
+
 const struct distro_arch_series *get_distro_arch_series(const char *url);
 
+/*
+ * 'date_frozen': date after which the binary cannot be downloaded, 0 if
+ * it is still available.
+ * 'refresh': if 0, the cached totals are returned without retrieving
+ * the new ones. They are retrieved anyway if none are cached.
+ */
 struct daily_download_total **get_daily_download_totals(const char *binary_url,
-							time_t date_created);
+							time_t date_created,
+							time_t date_frozen,
+							int refresh);
+
+/*
+ * Stores in 'state' the retrieval state of the cached totals of a
+ * binary. Returns -1 if there is none.
+ */
+int get_ddts_state(const char *binary_url, struct ddts_state *state);
+
+/*
+ * Sets the number of days during which the download totals of a day
+ * can still change. Older totals are cached and never retrieved again.
+ */
+void ddts_set_settling_days(int days);
+
+/*
+ * Sets the maximal number of concurrent requests used by a retrieval,
+ * 1 by default.
+ */
+void lp_ws_set_jobs(int jobs);
 
 const struct distro_series *get_distro_series(const char *distro_series_url);
 
+/*
+ * Stores the distro snapshot if it changed, with the objects of its
+ * refresh once retrieved, and starts a refresh if it is stale. Called
+ * by the daemon before each refresh of the PPAs, while none of them is
+ * processed.
+ */
+void lp_ws_refresh_distros();
+
+/*
+ * Waits for the refresh of the distro snapshot, stores it if needed and
+ * releases the retrieved distro objects.
+ */
 void lp_ws_cleanup();
 
 #endif
@@ -20,35 +20,196 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <fcntl.h>
 #include <getopt.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
-#include <cache.h>
 #include <config.h>
 #include <fcache.h>
 #include <html.h>
 #include <http.h>
+#include <list.h>
 #include <lp_ws.h>
 #include <pio.h>
 #include <plog.h>
 #include <ppastats.h>
+#include <ptime.h>
+#include <scheduler.h>
+#include <series.h>
+#include <server.h>
+#include <workers.h>
 
 static const char *program_name;
 
-static void display_published_binaries(const char *owner,
-				       const char *ppa,
-				       const char *package_status,
-				       int ws_size)
+static void print_timings(double seconds)
+{
+	struct bpph_timings bpph;
+
+	get_bpph_timings(&bpph);
+
+	fprintf(stderr, _("Timings:\n"));
+	fprintf(stderr, _("  total:          %.3f s\n"), seconds);
+	fprintf(stderr,
+		_("  bpph pages:     %d pages, %ld entries, %zu bytes, "
+		  "%.3f s\n"),
+		bpph.pages,
+		bpph.entries,
+		bpph.bytes,
+		bpph.seconds);
+	if (bpph.auto_ws_size)
+		fprintf(stderr,
+			_("  bpph page size: %d (auto)\n"),
+			bpph.ws_size);
+	else
+		fprintf(stderr, _("  bpph page size: %d\n"), bpph.ws_size);
+}
+
+/*
+ * Options of the text output restricted to a range of days, answered
+ * from the prefix sums of the series.
+ */
+struct report {
+	int enabled;
+	/* LONG_MIN and LONG_MAX for the first and last days of the PPA */
+	long from;
+	long to;
+	/* 1 to compare with the period of the same length just before */
+	int compare;
+	/* length of the rolling windows, 0 if none */
+	int window;
+};
+
+static struct report report;
+
+static void print_count(const char *indent,
+			const char *name,
+			const struct series *s,
+			long from,
+			long to)
+{
+	long count, previous;
+
+	count = series_sum(s, from, to);
+
+	printf("%s%s (%ld", indent, name, count);
+
+	if (report.compare) {
+		previous = series_sum_previous(s, from, to);
+		printf(_(", previous %ld, %+ld"), previous, count - previous);
+		if (previous)
+			printf(", %+.1f%%",
+			       100.0 * (count - previous) / previous);
+	}
+
+	printf(")\n");
+}
+
+static void print_rolling_sums(const char *indent,
+			       const struct series *s,
+			       long from,
+			       long to)
+{
+	long *sums, day;
+	int y, m, d;
+
+	if (!report.window || from > to)
+		return ;
+
+	sums = malloc((to - from + 1) * sizeof(long));
+	if (!sums) {
+		log_err(_("Failed to compute the rolling sums"));
+		return ;
+	}
+
+	series_rolling_sums(s, from, to, report.window, sums);
+
+	for (day = from; day <= to; day++) {
+		days_to_date(day, &y, &m, &d);
+		printf("%s%04d-%02d-%02d (%ld)\n",
+		       indent, y, m, d, sums[day - from]);
+	}
+
+	free(sums);
+}
+
+/*
+ * Prints the downloads of the range of days of the report for the PPA,
+ * its packages, their versions and their distributions, followed by
+ * the rolling sums of the PPA and of each package. Each number is
+ * computed in constant time.
+ */
+static void print_ppa_report(struct ppa_stats *ppa)
+{
+	struct package_stats **packages;
+	struct version_stats **versions;
+	struct distro_stats **distros;
+	long from, to;
+	int y, m, d;
+
+	from = report.from;
+	if (from == LONG_MIN)
+		from = ppa->series->first_day;
+
+	to = report.to;
+	if (to == LONG_MAX)
+		to = ppa->series->first_day + ppa->series->n_days - 1;
+
+	/* without any download, an open range has no day */
+	if (!ppa->series->n_days || from > to) {
+		printf(_("no downloads\n"));
+		return ;
+	}
+
+	days_to_date(from, &y, &m, &d);
+	printf(_("from %04d-%02d-%02d"), y, m, d);
+	days_to_date(to, &y, &m, &d);
+	printf(_(" to %04d-%02d-%02d\n"), y, m, d);
+
+	print_count("", _("total"), ppa->series, from, to);
+	print_rolling_sums("\t", ppa->series, from, to);
+
+	for (packages = ppa->packages; packages && *packages; packages++) {
+		print_count("",
+			    (*packages)->name,
+			    (*packages)->series,
+			    from,
+			    to);
+		print_rolling_sums("\t", (*packages)->series, from, to);
+
+		for (versions = (*packages)->versions; *versions; versions++)
+			print_count("\t",
+				    (*versions)->version,
+				    (*versions)->series,
+				    from,
+				    to);
+
+		for (distros = (*packages)->distros; *distros; distros++)
+			print_count("\t",
+				    (*distros)->name,
+				    (*distros)->series,
+				    from,
+				    to);
+	}
+}
+
+static void print_ppa_stats(struct ppa_stats *ppastats)
 {
-	struct ppa_stats *ppastats;
 	struct package_stats **packages;
 	struct version_stats **versions;
 	struct distro_stats **distros;
 	struct arch_stats **archs;
 
-	ppastats = create_ppa_stats(owner, ppa, package_status, ws_size);
+	if (report.enabled) {
+		print_ppa_report(ppastats);
+		return ;
+	}
+
 	packages = ppastats->packages;
 	while (packages && *packages) {
 		struct package_stats *p = *packages;
@@ -86,8 +247,496 @@ static void display_published_binaries(const char *owner,
 
 		packages++;
 	}
+}
+
+static int display_published_binaries(const char *owner,
+				      const char *ppa,
+				      const char *package_status,
+				      int ws_size,
+				      int jobs)
+{
+	struct ppa_stats *ppastats;
+
+	ppastats = create_ppa_stats(owner, ppa, package_status, ws_size, jobs);
+	if (!ppastats)
+		return -1;
+
+	print_ppa_stats(ppastats);
 
 	ppa_stats_free(ppastats);
+
+	return 0;
+}
+
+/* Default delay between two refreshes of a PPA by the daemon. */
+static const int DAEMON_DEFAULT_INTERVAL = 60 * 60;
+
+/* Maximal delay, reached by the PPAs without new downloads. */
+static const int DAEMON_MAX_INTERVAL = 24 * 60 * 60;
+
+/* Characters separating the owner and the name of a PPA in a batch. */
+static const char *BATCH_SEPARATORS = " \t\r\n/";
+
+struct batch_ppa {
+	char *owner;
+	char *name;
+	/*
+	 * statistics to print when there is no output directory, kept
+	 * for the index page of the owner and by the daemon
+	 */
+	struct ppa_stats *stats;
+	/* 1 if the total of the last refresh differs from the previous */
+	int changed;
+	/* 1 if the statistics of the last refresh could not be created */
+	int failed;
+	/* 1 once the pages have been generated */
+	int generated;
+	/* time of the next refresh by the daemon and its delay */
+	time_t next;
+	int interval;
+};
+
+/* PPAs processed by the same process and the options applied to them. */
+struct batch {
+	struct batch_ppa *ppas;
+	int n;
+	/* owner of all the PPAs when listing the PPAs of an owner */
+	const char *owner;
+	/* 1 if the pages of its only PPA go to the output directory */
+	int single;
+	const char *package_status;
+	const char *output_dir;
+	int install_static_files;
+	int ws_size;
+	int jobs;
+	/* share of the jobs of each PPA processed at once */
+	int ppa_jobs;
+	/* 1 if the statistics are kept between the refreshes */
+	int daemon;
+	/* 1 if the statistics are published to the query server */
+	int serve;
+	/* indexes of the PPAs to process */
+	int *selected;
+};
+
+/*
+ * Reads the PPAs of a batch file, '-' for the standard input. Each
+ * line holds an owner and a PPA name separated by spaces or by a '/'.
+ * The empty lines and the lines starting with '#' are ignored.
+ *
+ * Returns 0 or -1 if the file cannot be read or if a line is invalid.
+ */
+static int read_batch(const char *path, struct batch *b)
+{
+	FILE *f;
+	char *line, *owner, *name, *saveptr;
+	size_t size;
+	int n, ret;
+
+	if (!strcmp(path, "-"))
+		f = stdin;
+	else
+		f = fopen(path, "r");
+
+	if (!f) {
+		fprintf(stderr, _("Failed to open the batch file %s\n"), path);
+		return -1;
+	}
+
+	b->ppas = NULL;
+	b->n = 0;
+	b->owner = NULL;
+	b->single = 0;
+	line = NULL;
+	size = 0;
+	n = 0;
+	ret = 0;
+
+	while (getline(&line, &size, f) != -1) {
+		n++;
+
+		owner = strtok_r(line, BATCH_SEPARATORS, &saveptr);
+		if (!owner || *owner == '#')
+			continue;
+
+		name = strtok_r(NULL, BATCH_SEPARATORS, &saveptr);
+		if (!name || strtok_r(NULL, BATCH_SEPARATORS, &saveptr)) {
+			fprintf(stderr, _("%s:%d: invalid PPA\n"), path, n);
+			ret = -1;
+			break;
+		}
+
+		b->ppas = realloc(b->ppas,
+				  (b->n + 1) * sizeof(struct batch_ppa));
+		memset(&b->ppas[b->n], 0, sizeof(struct batch_ppa));
+		b->ppas[b->n].owner = strdup(owner);
+		b->ppas[b->n].name = strdup(name);
+		b->n++;
+	}
+
+	free(line);
+
+	if (f != stdin)
+		fclose(f);
+
+	return ret;
+}
+
+/* Lists the PPAs of an owner, returns 0 or -1 if they are unknown. */
+static int read_owner(const char *owner, struct batch *b)
+{
+	char **names;
+	int i;
+
+	names = get_ppa_names(owner);
+	if (!names) {
+		fprintf(stderr,
+			_("Failed to retrieve the PPAs of %s\n"),
+			owner);
+		return -1;
+	}
+
+	b->n = vector_length((void **)names);
+	b->ppas = NULL;
+	b->owner = owner;
+	b->single = 0;
+
+	if (b->n) {
+		b->ppas = calloc(b->n, sizeof(struct batch_ppa));
+		if (!b->ppas) {
+			fprintf(stderr,
+				_("Failed to list the PPAs of %s\n"),
+				owner);
+			for (i = 0; i < b->n; i++)
+				free(names[i]);
+			vector_free((void **)names);
+			b->n = 0;
+			return -1;
+		}
+	}
+
+	for (i = 0; i < b->n; i++) {
+		b->ppas[i].owner = strdup(owner);
+		b->ppas[i].name = names[i];
+	}
+
+	vector_free((void **)names);
+
+	return 0;
+}
+
+/* Makes a batch of a single PPA, for the daemon. */
+static void read_ppa(const char *owner, const char *name, struct batch *b)
+{
+	b->n = 1;
+	b->ppas = malloc(sizeof(struct batch_ppa));
+	b->owner = NULL;
+	b->single = 1;
+
+	memset(b->ppas, 0, sizeof(struct batch_ppa));
+	b->ppas[0].owner = strdup(owner);
+	b->ppas[0].name = strdup(name);
+}
+
+static void process_batch_ppa(int i, void *data)
+{
+	struct batch *b;
+	struct batch_ppa *p;
+	struct ppa_stats *stats;
+	char *tmp, *dir;
+
+	b = data;
+	p = &b->ppas[b->selected ? b->selected[i] : i];
+
+	stats = create_ppa_stats(p->owner,
+				 p->name,
+				 b->package_status,
+				 b->ws_size,
+				 b->ppa_jobs);
+
+	/* the PPA is skipped, the others go on */
+	p->failed = !stats;
+	if (p->failed)
+		return ;
+
+	if (p->stats)
+		p->changed = stats->download_count != p->stats->download_count;
+	else
+		p->changed = 1;
+
+	/* the server does not use the previous statistics anymore */
+	if (b->serve && server_publish(p->stats, stats))
+		log_err(_("Failed to publish the PPA %s/%s"),
+			p->owner,
+			p->name);
+
+	if (p->stats)
+		ppa_stats_free(p->stats);
+	p->stats = stats;
+
+	if (!b->output_dir)
+		return ;
+
+	if (b->single) {
+		dir = strdup(b->output_dir);
+	} else if (b->owner) {
+		dir = path_append(b->output_dir, p->name);
+	} else {
+		tmp = path_append(b->output_dir, p->owner);
+		dir = path_append(tmp, p->name);
+		free(tmp);
+	}
+
+	ppa_stats_to_html(p->stats,
+			  dir,
+			  b->install_static_files && !p->generated);
+	p->generated = 1;
+
+	free(dir);
+
+	/* kept for the index page of the owner */
+	if (!b->owner && !b->daemon) {
+		ppa_stats_free(p->stats);
+		p->stats = NULL;
+	}
+}
+
+/*
+ * Processes 'n' PPAs, the selected ones if any. The jobs are split
+ * between the PPAs processed at once instead of being used by each of
+ * them.
+ */
+static void process_batch(struct batch *b, int n)
+{
+	int workers;
+
+	if (!n)
+		return ;
+
+	workers = n < b->jobs ? n : b->jobs;
+	b->ppa_jobs = b->jobs / workers;
+	lp_ws_set_jobs(b->ppa_jobs);
+
+	workers_run(n, workers, process_batch_ppa, b);
+}
+
+static void generate_owner_page(struct batch *b)
+{
+	struct ppa_stats **ppas;
+	int i, n;
+
+	ppas = malloc((b->n + 1) * sizeof(struct ppa_stats *));
+	for (i = 0, n = 0; i < b->n; i++)
+		if (b->ppas[i].stats)
+			ppas[n++] = b->ppas[i].stats;
+	ppas[n] = NULL;
+
+	owner_to_html(b->owner, ppas, b->output_dir, b->install_static_files);
+
+	free(ppas);
+}
+
+/*
+ * Processes 'jobs' PPAs at once. The pages of a PPA are generated into
+ * OUTPUT_DIR/OWNER/NAME, or into OUTPUT_DIR/NAME below the index page
+ * of the owner when listing the PPAs of an owner. The text output is
+ * printed in the order of the batch.
+ *
+ * Returns 0 or -1 if some PPAs failed, they are skipped. When listing
+ * the PPAs of an owner, -1 only if all of them failed.
+ */
+static int run_batch(struct batch *b)
+{
+	struct batch_ppa *p;
+	int i, n_failed;
+
+	process_batch(b, b->n);
+
+	if (b->owner && b->output_dir)
+		generate_owner_page(b);
+
+	n_failed = 0;
+	for (i = 0; i < b->n; i++) {
+		p = &b->ppas[i];
+
+		if (p->failed) {
+			n_failed++;
+			continue;
+		}
+
+		if (b->output_dir)
+			continue;
+
+		printf("%s/%s:\n", p->owner, p->name);
+		print_ppa_stats(p->stats);
+	}
+
+	/*
+	 * The PPAs of an owner often include some without binaries, they
+	 * are left out of its index page and only fail the run if none of
+	 * them could be processed.
+	 */
+	if (b->owner) {
+		if (n_failed)
+			log_err(_("%d of the %d PPAs of %s skipped"),
+				n_failed,
+				b->n,
+				b->owner);
+
+		return b->n && n_failed == b->n ? -1 : 0;
+	}
+
+	return n_failed ? -1 : 0;
+}
+
+static volatile sig_atomic_t daemon_stopped;
+
+/*
+ * Written by the signal handler to wake up the daemon waiting for its
+ * next refresh, the signal may be received by another thread.
+ */
+static int stop_pipe[2];
+
+static void stop_daemon(int sig)
+{
+	daemon_stopped = 1;
+
+	if (write(stop_pipe[1], "", 1) < 0)
+		return ;
+}
+
+/* Waits until 'next' or until the daemon is stopped. */
+static void wait_next_refresh(time_t next)
+{
+	struct pollfd pfd;
+	time_t now;
+
+	pfd.fd = stop_pipe[0];
+	pfd.events = POLLIN;
+
+	while (!daemon_stopped && (now = time(NULL)) < next)
+		poll(&pfd, 1, (next - now) * 1000);
+}
+
+/*
+ * Refreshes the PPAs due, at most 'jobs' at once, and computes the
+ * time of their next refresh. The delay of a PPA is doubled after each
+ * refresh without new downloads or which failed, up to
+ * DAEMON_MAX_INTERVAL, and set back to 'interval' when there are some.
+ * The distro snapshot is stored and checked for staleness beforehand.
+ */
+static void refresh_due_ppas(struct batch *b, int interval)
+{
+	struct batch_ppa *p;
+	time_t now;
+	int i, n;
+
+	now = time(NULL);
+
+	for (i = 0, n = 0; i < b->n; i++)
+		if (b->ppas[i].next <= now)
+			b->selected[n++] = i;
+
+	log_debug(_("daemon: refreshing %d PPAs"), n);
+
+	lp_ws_refresh_distros();
+	scheduler_restart();
+	process_batch(b, n);
+
+	if (b->owner && b->output_dir)
+		generate_owner_page(b);
+
+	now = time(NULL);
+	for (i = 0; i < n; i++) {
+		p = &b->ppas[b->selected[i]];
+
+		/* a failed PPA backs off, its last statistics are kept */
+		if ((p->changed && !p->failed) || !p->interval)
+			p->interval = interval;
+		else if (p->interval * 2 <= DAEMON_MAX_INTERVAL)
+			p->interval *= 2;
+		else if (p->interval < DAEMON_MAX_INTERVAL)
+			p->interval = DAEMON_MAX_INTERVAL;
+
+		p->next = now + p->interval;
+
+		if (p->failed)
+			log_err(_("daemon: failed to refresh %s/%s, next "
+				  "attempt in %d seconds"),
+				p->owner,
+				p->name,
+				p->interval);
+	}
+}
+
+/*
+ * Keeps the statistics of the PPAs and refreshes them until SIGINT or
+ * SIGTERM, each one on its own schedule. The caches, the connections
+ * and the templates stay loaded, the pages whose content did not
+ * change are not rewritten. The refreshed statistics are published to
+ * the query server, if any.
+ */
+static void run_daemon(struct batch *b, int interval)
+{
+	struct sigaction sa;
+	time_t next;
+	int i;
+
+	if (!b->n) {
+		log_err(_("No PPA to refresh"));
+		return ;
+	}
+
+	b->selected = malloc(b->n * sizeof(int));
+	if (!b->selected || pipe(stop_pipe)) {
+		log_err(_("Failed to start the daemon"));
+		free(b->selected);
+		b->selected = NULL;
+		return ;
+	}
+	/* the pipe is kept open, the handler may still write to it */
+	fcntl(stop_pipe[1], F_SETFL, O_NONBLOCK);
+
+	memset(&sa, 0, sizeof(struct sigaction));
+	sa.sa_handler = stop_daemon;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	b->daemon = 1;
+
+	while (!daemon_stopped) {
+		refresh_due_ppas(b, interval);
+
+		next = 0;
+		for (i = 0; i < b->n; i++)
+			if (!next || b->ppas[i].next < next)
+				next = b->ppas[i].next;
+
+		wait_next_refresh(next);
+	}
+
+	log_debug(_("daemon stopped"));
+
+	free(b->selected);
+	b->selected = NULL;
+}
+
+static void batch_free(struct batch *b)
+{
+	struct batch_ppa *p;
+	int i;
+
+	for (i = 0; i < b->n; i++) {
+		p = &b->ppas[i];
+
+		if (p->stats)
+			ppa_stats_free(p->stats);
+
+		free(p->owner);
+		free(p->name);
+	}
+
+	free(b->ppas);
 }
 
 static struct option long_options[] = {
@@ -99,6 +748,20 @@ static struct option long_options[] = {
 	{"skip-js-css", no_argument, 0, 'S'},
 	{"get-bpph-size", required_argument, 0, 0},
 	{"theme-dir", required_argument, 0, 't'},
+	{"jobs", required_argument, 0, 'j'},
+	{"settling-days", required_argument, 0, 0},
+	{"refresh-budget", required_argument, 0, 0},
+	{"time-budget", required_argument, 0, 0},
+	{"timings", no_argument, 0, 0},
+	{"batch", required_argument, 0, 0},
+	{"max-requests", required_argument, 0, 0},
+	{"owner", required_argument, 0, 0},
+	{"daemon", optional_argument, 0, 0},
+	{"serve", required_argument, 0, 0},
+	{"from", required_argument, 0, 0},
+	{"to", required_argument, 0, 0},
+	{"compare", no_argument, 0, 0},
+	{"window", required_argument, 0, 0},
 	{0, 0, 0, 0}
 };
 
@@ -116,6 +779,8 @@ static void print_version()
 static void print_help()
 {
 	printf(_("Usage: %s [OPTION]... PPA_OWNER PPA_NAME\n"), program_name);
+	printf(_("  or:  %s [OPTION]... --batch=FILE\n"), program_name);
+	printf(_("  or:  %s [OPTION]... --owner=PPA_OWNER\n"), program_name);
 
 	puts(_(
 "ppastats is a command application for generating PPA statistics.\n"));
@@ -142,7 +807,61 @@ static void print_help()
 " -S, --skip-js-css         skip installation of js and css files"));
 	puts(_(
 " --get-bpph-size=[s]       size of the replies of webservice requests to get\n"
-"                           the list of binary packages. Between 1 and 300."));
+"                           the list of binary packages. Between 1 and 300,\n"
+"                           or 'auto' for choosing the size giving the best\n"
+"                           throughput."));
+	puts(_(
+"  -j, --jobs=[N]           number of threads used to retrieve and aggregate\n"
+"                           the download totals, and of concurrent requests\n"
+"                           of the other retrievals (default: 1)"));
+	puts(_(
+" --settling-days=[N]       number of days during which the download totals\n"
+"                           of a day can still change and are retrieved\n"
+"                           again (default: 28)"));
+	puts(_(
+" --refresh-budget=[N]      refresh the download totals of at most N\n"
+"                           binaries, the most downloaded first, and use the\n"
+"                           cached totals of the others"));
+	puts(_(
+" --time-budget=[SECONDS]   stop refreshing the download totals after SECONDS\n"
+"                           and use the cached totals of the others"));
+	puts(_(
+" --timings                 print a summary of the durations on the error\n"
+"                           output"));
+	puts(_(
+" --batch=[FILE]            process the PPAs listed in FILE, or in the\n"
+"                           standard input if FILE is '-', one 'OWNER NAME'\n"
+"                           or 'OWNER/NAME' per line. N PPAs are processed\n"
+"                           at once with --jobs=N, the HTML pages of a PPA\n"
+"                           are generated into PATH/OWNER/NAME"));
+	puts(_(
+" --owner=[PPA_OWNER]       process all the PPAs of PPA_OWNER like --batch,\n"
+"                           their HTML pages are generated into PATH/NAME\n"
+"                           below an index page listing their totals"));
+	puts(_(
+" --daemon[=SECONDS]        keep running and refresh the pages of each PPA\n"
+"                           every SECONDS (default: 3600), less often while\n"
+"                           it has no new downloads. Requires --output-dir\n"
+"                           or --serve, stops on SIGINT or SIGTERM"));
+	puts(_(
+" --serve=[PORT]            with --daemon, answer JSON queries on the\n"
+"                           statistics on the local port PORT"));
+	puts(_(
+" --from=[DATE]             print the downloads from DATE, YYYY-MM-DD,\n"
+"                           instead of the totals. The versions are followed\n"
+"                           by the distributions of the package"));
+	puts(_(
+" --to=[DATE]               print the downloads up to DATE included"));
+	puts(_(
+" --compare                 with --from or --to, compare the downloads with\n"
+"                           the period of the same length just before"));
+	puts(_(
+" --window=[DAYS]           with --from or --to, print the downloads of the\n"
+"                           DAYS days ending on each day of the period for\n"
+"                           the PPA and for its packages"));
+	puts(_(
+" --max-requests=[N]        limit the number of webservice requests in\n"
+"                           progress to N"));
 	puts("");
 
 	printf(_("Report bugs to: %s\n"), PACKAGE_BUGREPORT);
@@ -153,7 +872,12 @@ static void print_help()
 int main(int argc, char **argv)
 {
 	char *owner, *ppa, *package_status, *output_dir, *theme_dir, *log, *tmp;
-	int optc, output_html, cmdok, install_static_files, ws_size, opti;
+	int optc, output_html, cmdok, install_static_files, ws_size, opti, jobs;
+	int settling_days, refresh_budget, time_budget, timings, max_requests;
+	int daemon_interval, serve_port, failed;
+	char *batch_path, *owner_name;
+	struct batch batch;
+	double start;
 
 	program_name = argv[0];
 
@@ -168,13 +892,95 @@ int main(int argc, char **argv)
 	output_html = 0;
 	ws_size = -1;
 	theme_dir = NULL;
+	jobs = 1;
+	settling_days = -1;
+	refresh_budget = 0;
+	time_budget = 0;
+	timings = 0;
+	max_requests = 0;
+	failed = 0;
+	batch_path = NULL;
+	owner_name = NULL;
+	daemon_interval = 0;
+	serve_port = 0;
+	report.enabled = 0;
+	report.from = LONG_MIN;
+	report.to = LONG_MAX;
+	report.compare = 0;
+	report.window = 0;
+	start = get_monotonic_time();
 
-	while ((optc = getopt_long(argc, argv, "vho:t:ds:S", long_options,
+	while ((optc = getopt_long(argc, argv, "vho:t:ds:Sj:", long_options,
 				   &opti)) != -1) {
 		switch (optc) {
 		case 0:
-			if (!strcmp(long_options[opti].name, "get-bpph-size"))
-				ws_size = atoi(optarg);
+			if (!strcmp(long_options[opti].name, "get-bpph-size")) {
+				if (!strcmp(optarg, "auto"))
+					ws_size = WS_SIZE_AUTO;
+				else if ((ws_size = atoi(optarg)) < 1)
+					ws_size = -1;
+			} else if (!strcmp(long_options[opti].name,
+					   "timings")) {
+				timings = 1;
+			} else if (!strcmp(long_options[opti].name,
+					   "settling-days")) {
+				settling_days = atoi(optarg);
+				if (settling_days < 0)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "refresh-budget")) {
+				refresh_budget = atoi(optarg);
+				if (refresh_budget < 1)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "time-budget")) {
+				time_budget = atoi(optarg);
+				if (time_budget < 1)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "batch")) {
+				free(batch_path);
+				batch_path = strdup(optarg);
+			} else if (!strcmp(long_options[opti].name,
+					   "owner")) {
+				free(owner_name);
+				owner_name = strdup(optarg);
+			} else if (!strcmp(long_options[opti].name,
+					   "daemon")) {
+				if (optarg)
+					daemon_interval = atoi(optarg);
+				else
+					daemon_interval
+						= DAEMON_DEFAULT_INTERVAL;
+				if (daemon_interval < 1)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "serve")) {
+				serve_port = atoi(optarg);
+				if (serve_port < 1 || serve_port > 65535)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name, "from")) {
+				report.enabled = 1;
+				if (series_parse_day(optarg, &report.from))
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name, "to")) {
+				report.enabled = 1;
+				if (series_parse_day(optarg, &report.to))
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "compare")) {
+				report.compare = 1;
+			} else if (!strcmp(long_options[opti].name,
+					   "window")) {
+				report.window = atoi(optarg);
+				if (report.window < 1)
+					cmdok = 0;
+			} else if (!strcmp(long_options[opti].name,
+					   "max-requests")) {
+				max_requests = atoi(optarg);
+				if (max_requests < 1)
+					cmdok = 0;
+			}
 			break;
 		case 'o':
 			output_html = 1;
@@ -200,13 +1006,25 @@ int main(int argc, char **argv)
 		case 'S':
 			install_static_files = 0;
 			break;
+		case 'j':
+			jobs = atoi(optarg);
+			if (jobs < 1)
+				cmdok = 0;
+			break;
 		default:
 			cmdok = 0;
 			break;
 		}
 	}
 
-	if (!cmdok || optind + 2 != argc) {
+	if ((batch_path && owner_name)
+	    || (daemon_interval && !output_html && !serve_port)
+	    || (serve_port && !daemon_interval)
+	    || ((report.compare || report.window) && !report.enabled)
+	    || (report.enabled && (output_html || daemon_interval)))
+		cmdok = 0;
+
+	if (!cmdok || optind + (batch_path || owner_name ? 0 : 2) != argc) {
 		fprintf(stderr,
 			_("Try `%s --help' for more information.\n"),
 			program_name);
@@ -219,31 +1037,84 @@ int main(int argc, char **argv)
 	free(tmp);
 	free(log);
 
-	owner = argv[optind];
-	ppa = argv[optind+1];
+	if (batch_path || owner_name) {
+		if (batch_path && read_batch(batch_path, &batch))
+			exit(EXIT_FAILURE);
+		if (owner_name && read_owner(owner_name, &batch))
+			exit(EXIT_FAILURE);
+		owner = NULL;
+		ppa = NULL;
+	} else {
+		owner = argv[optind];
+		ppa = argv[optind+1];
+		if (daemon_interval)
+			read_ppa(owner, ppa, &batch);
+	}
+
+	batch.package_status = package_status;
+	batch.output_dir = output_dir;
+	batch.install_static_files = install_static_files;
+	batch.ws_size = ws_size;
+	batch.jobs = jobs;
+	batch.daemon = 0;
+	batch.serve = serve_port != 0;
+	batch.selected = NULL;
+
+	if (settling_days >= 0)
+		ddts_set_settling_days(settling_days);
+
+	lp_ws_set_jobs(jobs);
+
+	if (refresh_budget || time_budget)
+		scheduler_set_budget(refresh_budget, time_budget);
+
+	if (max_requests)
+		http_set_max_requests(max_requests);
 
 	if (output_html) {
 		if (theme_dir)
 			html_set_theme_dir(theme_dir);
 		else
 			html_set_theme_dir(DEFAULT_THEME_DIR);
-		ppa_to_html(owner,
-			    ppa,
-			    package_status,
-			    output_dir,
-			    install_static_files,
-			    ws_size);
+	}
+
+	if (daemon_interval) {
+		if (serve_port && server_start(serve_port))
+			exit(EXIT_FAILURE);
+		run_daemon(&batch, daemon_interval);
+		server_stop();
+		batch_free(&batch);
+	} else if (batch_path || owner_name) {
+		failed = run_batch(&batch);
+		batch_free(&batch);
+	} else if (output_html) {
+		failed = ppa_to_html(owner,
+				     ppa,
+				     package_status,
+				     output_dir,
+				     install_static_files,
+				     ws_size,
+				     jobs);
 	} else {
-		display_published_binaries(owner, ppa, package_status, ws_size);
+		failed = display_published_binaries(owner,
+						    ppa,
+						    package_status,
+						    ws_size,
+						    jobs);
 	}
 
+	if (timings)
+		print_timings(get_monotonic_time() - start);
+
 	/* for valgrind.... */
 	free(package_status);
 	free(output_dir);
+	free(batch_path);
+	free(owner_name);
+	lp_ws_cleanup();
 	http_cleanup();
-	cache_cleanup();
 	fcache_cleanup();
 	html_cleanup();
 
-	exit(EXIT_SUCCESS);
+	exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
 }
@@ -58,7 +58,8 @@ void log_close()
 static void vlogf(int lvl, const char *fct, const char *fmt, va_list ap)
 {
 	char buffer[1 + LOG_BUFFER];
-	char *lvl_str, *t;
+	char t[ISO8601_TIME_SIZE];
+	char *lvl_str;
 	FILE *stdf;
 
 	if (lvl > LOG_INFO && (!file || lvl > log_level))
@@ -84,8 +85,7 @@ static void vlogf(int lvl, const char *fct, const char *fmt, va_list ap)
 		lvl_str = "[??]";
 	}
 
-	t = get_current_ISO8601_time();
-	if (!t)
+	if (!get_current_ISO8601_time_r(t))
 		return ;
 
 	if (file && lvl <= log_level) {
@@ -95,8 +95,6 @@ static void vlogf(int lvl, const char *fct, const char *fmt, va_list ap)
 		else
 			fprintf(file, "[%s] %s %s\n", t, lvl_str, buffer);
 		fflush(file);
-	} else {
-		t = NULL;
 	}
 
 	if (lvl <= LOG_INFO) {
@@ -106,13 +104,11 @@ static void vlogf(int lvl, const char *fct, const char *fmt, va_list ap)
 			stdf = stdout;
 
 		if (fct)
-			fprintf(file,
+			fprintf(stdf,
 				"[%s] %s %s(): %s\n", t, lvl_str, fct, buffer);
 		else
 			fprintf(stdf, "[%s] %s %s\n", t, lvl_str, buffer);
 	}
-
-	free(t);
 }
 
 void log_printf(int lvl, const char *fmt, ...)
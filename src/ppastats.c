@@ -20,6 +20,7 @@
 #include <libintl.h>
 #define _(String) gettext(String)
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +29,16 @@
 #include <lp_ws.h>
 #include <plog.h>
 #include <ppastats.h>
+#include <queue.h>
+#include <scheduler.h>
+#include <workers.h>
+
+/*
+ * Number of bpph entries aggregated by a single task. Small enough to
+ * balance the load between the workers, large enough to keep the
+ * number of partial results to merge low.
+ */
+static const int AGGREGATION_CHUNK_SIZE = 32;
 
 static void arch_stats_free(struct arch_stats *arch)
 {
@@ -44,6 +55,7 @@ static struct distro_stats *distro_stats_new(const char *name)
 	d->archs = NULL;
 	d->download_count = 0;
 	d->ddts = NULL;
+	d->series = NULL;
 
 	return d;
 }
@@ -58,10 +70,11 @@ static void distro_stats_free(struct distro_stats *distro)
 			arch_stats_free(*archs);
 			archs++;
 		}
-		free(distro->archs);
+		vector_free((void **)distro->archs);
 	}
 
 	daily_download_total_list_free(distro->ddts);
+	series_free(distro->series);
 
 	free(distro->name);
 	free(distro);
@@ -77,7 +90,7 @@ static void distro_stats_list_free(struct distro_stats **distros)
 			distro_stats_free(*cur);
 			cur++;
 		}
-		free(distros);
+		vector_free((void **)distros);
 	}
 }
 
@@ -85,6 +98,7 @@ static void version_stats_free(struct version_stats *version)
 {
 	distro_stats_list_free(version->distros);
 	daily_download_total_list_free(version->daily_download_totals);
+	series_free(version->series);
 
 	free(version->version);
 	free(version);
@@ -100,10 +114,11 @@ static void package_stats_free(struct package_stats *package)
 			version_stats_free(*versions);
 			versions++;
 		}
-		free(package->versions);
+		vector_free((void **)package->versions);
 	}
 	distro_stats_list_free(package->distros);
 	daily_download_total_list_free(package->daily_download_totals);
+	series_free(package->series);
 	free(package->name);
 	free(package);
 }
@@ -118,15 +133,17 @@ static struct package_stats *package_stats_new(const char *name)
 	p->download_count = 0;
 	p->daily_download_totals = NULL;
 	p->distros = NULL;
+	p->series = NULL;
 
 	return p;
 }
 
+/* Returns NULL if the package cannot be added. */
 static struct package_stats *get_package_stats(struct ppa_stats *stats,
 					       const char *name)
 
 {
-	struct package_stats *p, **p_cur, **tmp;
+	struct package_stats *p, **p_cur, **pkgs;
 
 	p_cur = stats->packages;
 	while (p_cur && *p_cur) {
@@ -140,9 +157,13 @@ static struct package_stats *get_package_stats(struct ppa_stats *stats,
 
 	p = package_stats_new(name);
 
-	tmp = (struct package_stats **)list_add((void **)stats->packages, p);
-	free(stats->packages);
-	stats->packages = tmp;
+	pkgs = (struct package_stats **)
+		vector_push((void **)stats->packages, p);
+	if (!pkgs) {
+		package_stats_free(p);
+		return NULL;
+	}
+	stats->packages = pkgs;
 
 	return p;
 }
@@ -157,14 +178,16 @@ static struct version_stats *version_stats_new(const char *version)
 	v->download_count = 0;
 	v->daily_download_totals = NULL;
 	v->date_created = 0;
+	v->series = NULL;
 
 	return v;
 }
 
+/* Returns NULL if the version cannot be added. */
 static struct version_stats *get_version_stats(struct package_stats *package,
 					       const char *version)
 {
-	struct version_stats *v, **cur, **tmp;
+	struct version_stats *v, **cur, **versions;
 
 	cur = package->versions;
 	while (cur && *cur) {
@@ -178,18 +201,22 @@ static struct version_stats *get_version_stats(struct package_stats *package,
 
 	v = version_stats_new(version);
 
-	tmp = (struct version_stats **)list_add((void **)package->versions,
-						v);
-	free((void **)package->versions);
-	package->versions = tmp;
+	versions = (struct version_stats **)
+		vector_push((void **)package->versions, v);
+	if (!versions) {
+		version_stats_free(v);
+		return NULL;
+	}
+	package->versions = versions;
 
 	return v;
 }
 
+/* Returns NULL if the distro cannot be added. */
 static struct distro_stats *get_distro_stats(struct version_stats *version,
 					     const char *name)
 {
-	struct distro_stats **cur, *d, **tmp;
+	struct distro_stats **cur, *d, **distros;
 
 	cur = version->distros;
 
@@ -204,18 +231,22 @@ static struct distro_stats *get_distro_stats(struct version_stats *version,
 
 	d = distro_stats_new(name);
 
-	tmp = (struct distro_stats **)list_add((void **)version->distros,
-					       d);
-	free(version->distros);
-	version->distros = tmp;
+	distros = (struct distro_stats **)
+		vector_push((void **)version->distros, d);
+	if (!distros) {
+		distro_stats_free(d);
+		return NULL;
+	}
+	version->distros = distros;
 
 	return d;
 }
 
+/* Returns NULL if the arch cannot be added. */
 static struct arch_stats *get_arch_stats(struct distro_stats *distro,
 					 const char *name)
 {
-	struct arch_stats **cur, *a, **tmp;
+	struct arch_stats **cur, *a, **archs;
 
 	cur = distro->archs;
 	while (cur && *cur) {
@@ -231,22 +262,25 @@ static struct arch_stats *get_arch_stats(struct distro_stats *distro,
 	a->name = strdup(name);
 	a->download_count = 0;
 
-	tmp = (struct arch_stats **)list_add((void **)distro->archs,
-					     a);
-	free((void **)distro->archs);
-	distro->archs = tmp;
+	archs = (struct arch_stats **)vector_push((void **)distro->archs, a);
+	if (!archs) {
+		arch_stats_free(a);
+		return NULL;
+	}
+	distro->archs = archs;
 
 	return a;
 }
 
 
-static struct daily_download_total **add_total
-(struct daily_download_total **totals, struct daily_download_total *total)
+/* Returns -1 if the day cannot be added, 'totals' is then unchanged. */
+static int add_total(struct daily_download_total ***totals,
+		     struct daily_download_total *total)
 {
-	struct daily_download_total **cur, **result, *item;
+	struct daily_download_total **cur, *item, *clone, **result;
 
-	if (totals) {
-		cur = totals;
+	if (*totals) {
+		cur = *totals;
 		while (*cur) {
 			item = *cur;
 
@@ -254,44 +288,48 @@ static struct daily_download_total **add_total
 			    item->date.tm_mon == total->date.tm_mon &&
 			    item->date.tm_mday == total->date.tm_mday) {
 				item->count += total->count;
-				return totals;
+				return 0;
 			}
 
 			cur++;
 		}
 	}
 
-	result = (struct daily_download_total **)list_add((void **)totals,
-							  ddt_clone(total));
-	return result;
+	clone = ddt_clone(total);
+	result = (struct daily_download_total **)
+		vector_push((void **)*totals, clone);
+	if (!result) {
+		free(clone);
+		return -1;
+	}
+	*totals = result;
+
+	return 0;
 }
 
-static struct daily_download_total **add_totals
-(struct daily_download_total **total1, struct daily_download_total **total2)
+/* Adds the days of 'total2' to '*total1', returns -1 on failure. */
+static int add_totals(struct daily_download_total ***total1,
+		      struct daily_download_total **total2)
 {
-	struct daily_download_total **cur, **result, **tmp;
-
-	result = total1;
-	cur = total2;
-	while (*cur) {
-		tmp = add_total(result, *cur);
-		if (result != total1 && result != tmp)
-			free(result);
-		result = tmp;
-		cur++;
-	}
+	struct daily_download_total **cur;
+
+	if (!total2)
+		return 0;
 
-	return result;
+	for (cur = total2; *cur; cur++)
+		if (add_total(total1, *cur))
+			return -1;
+
+	return 0;
 }
 
-static void
+static int
 pkg_add_distro(struct package_stats *pkg,
 	       const char *distro_name,
 	       int distro_count,
 	       struct daily_download_total **ddts)
 {
-	struct distro_stats **pkg_distros, *pkg_distro, **tmp;
-	struct daily_download_total **tmp_ddts;
+	struct distro_stats **pkg_distros, *pkg_distro;
 
 	pkg_distros = pkg->distros;
 	pkg_distro = NULL;
@@ -308,19 +346,18 @@ pkg_add_distro(struct package_stats *pkg,
 
 	if (!pkg_distro) {
 		pkg_distro = distro_stats_new(distro_name);
-		tmp = (struct distro_stats **)list_add((void **)pkg->distros,
-						       (void *)pkg_distro);
-		if (pkg->distros != tmp)
-			free(pkg->distros);
-		pkg->distros = tmp;
+		pkg_distros = (struct distro_stats **)
+			vector_push((void **)pkg->distros, pkg_distro);
+		if (!pkg_distros) {
+			distro_stats_free(pkg_distro);
+			return -1;
+		}
+		pkg->distros = pkg_distros;
 	}
 
 	pkg_distro->download_count += distro_count;
 
-	tmp_ddts = add_totals(pkg_distro->ddts, ddts);
-	if (pkg_distro->ddts && pkg_distro->ddts != tmp_ddts)
-		free(pkg_distro->ddts);
-	pkg_distro->ddts = tmp_ddts;
+	return add_totals(&pkg_distro->ddts, ddts);
 }
 
 static struct ppa_stats *ppa_stats_new(const char *owner, const char *ppa_name)
@@ -333,90 +370,495 @@ static struct ppa_stats *ppa_stats_new(const char *owner, const char *ppa_name)
 	ppa->packages = NULL;
 	ppa->daily_download_totals = NULL;
 	ppa->download_count = 0;
+	ppa->series = NULL;
 
 	return ppa;
 }
 
-struct ppa_stats *
-create_ppa_stats(const char *owner,
-		 const char *ppa_name,
-		 const char *package_status,
-		 int ws_size)
+/*
+ * Returns -1 if the bpph cannot be added to the stats, a bpph without
+ * download totals or distribution is skipped.
+ */
+static int ppa_stats_add_bpph(struct ppa_stats *ppa,
+			      const struct bpph_table *history,
+			      int i)
 {
-	struct ppa_stats *ppa;
-	struct bpph **history, **h_cur, *h;
-	char *ppa_url, *pkg_name, *pkg_version;
+	const char *pkg_name, *pkg_version, *self_link;
+	time_t date_created;
 	struct package_stats *pkg;
 	struct version_stats *version;
 	const struct distro_series *distro_series;
 	const struct distro_arch_series *arch_series;
 	struct distro_stats *distro;
 	struct arch_stats *arch;
-	int count;
-	struct daily_download_total **totals, **tmp;
+	int count, ret;
+	struct daily_download_total **totals;
+
+	self_link = bpph_get_self_link(history, i);
+	date_created = history->date_created[i];
+
+	totals = get_daily_download_totals(self_link,
+					   date_created,
+					   bpph_get_date_frozen(history, i),
+					   !scheduler_is_enabled());
+	if (!totals) {
+		log_err(_("Failed to retrieve download totals for %s"),
+			self_link);
+		return 0;
+	}
+	count = ddts_get_count(totals);
+	pkg_name = bpph_get_name(history, i);
+	pkg_version = bpph_get_version(history, i);
+	arch_series = get_distro_arch_series
+		(bpph_get_distro_arch_series_link(history, i));
+	distro_series = arch_series
+		? get_distro_series(arch_series->distroseries_link)
+		: NULL;
+
+	if (!distro_series) {
+		log_err(_("Failed to retrieve the distribution of %s"),
+			self_link);
+		daily_download_total_list_free(totals);
+		return 0;
+	}
+
+	ret = -1;
+
+	ppa->download_count += count;
+	if (add_totals(&ppa->daily_download_totals, totals))
+		goto out;
+
+	pkg = get_package_stats(ppa, pkg_name);
+	if (!pkg)
+		goto out;
+	pkg->download_count += count;
+	if (add_totals(&pkg->daily_download_totals, totals))
+		goto out;
+
+	version = get_version_stats(pkg, pkg_version);
+	if (!version)
+		goto out;
+	version->date_created = date_created;
+
+	version->download_count += count;
+	if (add_totals(&version->daily_download_totals, totals))
+		goto out;
+
+	distro = get_distro_stats(version, distro_series->name);
+	if (!distro)
+		goto out;
+	distro->download_count += count;
+
+	arch = get_arch_stats(distro, arch_series->architecture_tag);
+	if (!arch)
+		goto out;
+	arch->download_count += count;
+
+	ret = pkg_add_distro(pkg, distro_series->name, count, totals);
+
+ out:
+	daily_download_total_list_free(totals);
+
+	return ret;
+}
+
+static int version_stats_merge(struct version_stats *dst,
+			       struct version_stats *src)
+{
+	struct distro_stats **distros, *distro;
+	struct arch_stats **archs, *arch;
+
+	dst->date_created = src->date_created;
+	dst->download_count += src->download_count;
+
+	if (add_totals(&dst->daily_download_totals,
+		       src->daily_download_totals))
+		return -1;
+
+	for (distros = src->distros; distros && *distros; distros++) {
+		distro = get_distro_stats(dst, (*distros)->name);
+		if (!distro)
+			return -1;
+		distro->download_count += (*distros)->download_count;
+
+		for (archs = (*distros)->archs; archs && *archs; archs++) {
+			arch = get_arch_stats(distro, (*archs)->name);
+			if (!arch)
+				return -1;
+			arch->download_count += (*archs)->download_count;
+		}
+	}
+
+	return 0;
+}
+
+static int package_stats_merge(struct package_stats *dst,
+			       struct package_stats *src)
+{
+	struct version_stats **versions, *version;
+	struct distro_stats **distros;
+
+	dst->download_count += src->download_count;
+
+	if (add_totals(&dst->daily_download_totals,
+		       src->daily_download_totals))
+		return -1;
+
+	for (versions = src->versions; versions && *versions; versions++) {
+		version = get_version_stats(dst, (*versions)->version);
+		if (!version || version_stats_merge(version, *versions))
+			return -1;
+	}
+
+	for (distros = src->distros; distros && *distros; distros++)
+		if (pkg_add_distro(dst,
+				   (*distros)->name,
+				   (*distros)->download_count,
+				   (*distros)->ddts))
+			return -1;
+
+	return 0;
+}
+
+/*
+ * Merges 'src' into 'dst'. Merging the partial results in the order
+ * of the bpph list produces the same tree than a sequential
+ * aggregation of the whole list.
+ *
+ * Returns -1 if 'dst' cannot hold the merged stats.
+ */
+static int ppa_stats_merge(struct ppa_stats *dst, struct ppa_stats *src)
+{
+	struct package_stats **pkgs, *pkg;
 
-	ppa_url = get_archive_url(owner, ppa_name);
-	history = get_bpph_list(ppa_url, package_status, ws_size);
+	dst->download_count += src->download_count;
+
+	if (add_totals(&dst->daily_download_totals,
+		       src->daily_download_totals))
+		return -1;
+
+	for (pkgs = src->packages; pkgs && *pkgs; pkgs++) {
+		pkg = get_package_stats(dst, (*pkgs)->name);
+		if (!pkg || package_stats_merge(pkg, *pkgs))
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Chunk of the bpph list flowing through the aggregation pipeline:
+ * 'n' rows of a page from the row 'start'.
+ */
+struct chunk {
+	int seq;
+
+	const struct bpph_table *page;
+	int start;
+	int n;
+
+	struct ppa_stats *partial;
+};
+
+/*
+ * The bpph list is retrieved page by page by a dedicated thread which
+ * splits the rows of each page into chunks. The chunks are queued for the
+ * workers retrieving their download totals and building a partial
+ * ppa_stats for each of them. The partial results are merged by the
+ * calling thread in the order of the list.
+ */
+struct pipeline {
+	const char *owner;
+	const char *ppa_name;
+	const char *package_status;
+	int ws_size;
+	int jobs;
+
+	/* chunks waiting for their download totals */
+	struct queue *todo;
+	/* aggregated chunks waiting to be merged */
+	struct queue *done;
+
+	int n_chunks;
+	/* pages referenced by the chunks, freed once all are merged */
+	struct bpph_table **pages;
+	struct bpph_table *history;
+	/* set by the pager if a page cannot be kept */
+	int failed;
+};
+
+static void push_chunks(struct pipeline *p, const struct bpph_table *page)
+{
+	struct chunk *c;
+	int i, n, size;
+
+	n = page->length;
+	for (i = 0; i < n; i += size) {
+		size = n - i;
+		if (size > AGGREGATION_CHUNK_SIZE)
+			size = AGGREGATION_CHUNK_SIZE;
+
+		c = malloc(sizeof(struct chunk));
+		c->seq = p->n_chunks++;
+		c->page = page;
+		c->start = i;
+		c->n = size;
+		c->partial = NULL;
+
+		queue_push(p->todo, c);
+	}
+}
+
+/*
+ * With a refresh budget, the chunks are pushed once the download totals
+ * have been refreshed in the order of priority of the whole list.
+ */
+static void push_page(struct bpph_table *page, void *data)
+{
+	struct pipeline *p;
+
+	struct bpph_table **pages;
+
+	p = data;
+
+	pages = (struct bpph_table **)vector_push((void **)p->pages, page);
+	if (!pages) {
+		bpph_table_free(page);
+		p->failed = 1;
+		return ;
+	}
+	p->pages = pages;
+
+	if (!scheduler_is_enabled())
+		push_chunks(p, page);
+}
+
+static void *retrieve_history(void *data)
+{
+	struct pipeline *p;
+	char *ppa_url;
+	struct bpph_table **pages;
+
+	p = data;
+
+	ppa_url = get_archive_url(p->owner, p->ppa_name);
+	p->history = get_bpph_list(ppa_url,
+				   p->package_status,
+				   p->ws_size,
+				   push_page,
+				   p);
 	free(ppa_url);
 
-	if (!history) {
-		log_err(_("Failed to retrieve PPA information"));
-		exit(EXIT_FAILURE);
+	if (scheduler_is_enabled()) {
+		scheduler_refresh(p->history, p->jobs);
+
+		for (pages = p->pages; pages && *pages; pages++)
+			push_chunks(p, *pages);
+	}
+
+	queue_close(p->todo);
+
+	return NULL;
+}
+
+static void aggregate_chunks(int i, void *data)
+{
+	struct pipeline *p;
+	struct chunk *c;
+	int j;
+
+	p = data;
+
+	while ((c = queue_pop(p->todo))) {
+		c->partial = ppa_stats_new(p->owner, p->ppa_name);
+
+		/* a chunk which cannot be aggregated has no partial */
+		for (j = 0; j < c->n; j++)
+			if (ppa_stats_add_bpph(c->partial,
+					       c->page,
+					       c->start + j)) {
+				ppa_stats_free(c->partial);
+				c->partial = NULL;
+				break;
+			}
+
+		queue_push(p->done, c);
+	}
+}
+
+static void *run_aggregators(void *data)
+{
+	struct pipeline *p;
+
+	p = data;
+
+	workers_run(p->jobs, p->jobs, aggregate_chunks, p);
+
+	queue_close(p->done);
+
+	return NULL;
+}
+
+static void chunk_free(struct chunk *c)
+{
+	if (c->partial)
+		ppa_stats_free(c->partial);
+	free(c);
+}
+
+static void pipeline_free_history(struct pipeline *p)
+{
+	struct bpph_table **pages;
+
+	for (pages = p->pages; pages && *pages; pages++)
+		bpph_table_free(*pages);
+	vector_free((void **)p->pages);
+
+	bpph_table_free(p->history);
+}
+
+/* Builds the prefix sums of the aggregated series. */
+static void ppa_stats_index(struct ppa_stats *ppa)
+{
+	struct package_stats **pkgs;
+	struct version_stats **versions;
+	struct distro_stats **distros;
+	struct daily_download_total **ddts;
+
+	ppa->series = series_new(ppa->daily_download_totals);
+
+	for (pkgs = ppa->packages; pkgs && *pkgs; pkgs++) {
+		(*pkgs)->series = series_new((*pkgs)->daily_download_totals);
+
+		for (versions = (*pkgs)->versions;
+		     versions && *versions;
+		     versions++) {
+			ddts = (*versions)->daily_download_totals;
+			(*versions)->series = series_new(ddts);
+		}
+
+		for (distros = (*pkgs)->distros;
+		     distros && *distros;
+		     distros++)
+			(*distros)->series = series_new((*distros)->ddts);
+	}
+}
+
+struct ppa_stats *
+create_ppa_stats(const char *owner,
+		 const char *ppa_name,
+		 const char *package_status,
+		 int ws_size,
+		 int jobs)
+{
+	struct ppa_stats *ppa;
+	struct pipeline p;
+	pthread_t pager, aggregators;
+	struct chunk *c, **pending, **chunks;
+	int n_pending, next, n, failed;
+
+	p.owner = owner;
+	p.ppa_name = ppa_name;
+	p.package_status = package_status;
+	p.ws_size = ws_size;
+	p.jobs = jobs;
+	p.todo = queue_new(2 * jobs);
+	p.done = queue_new(2 * jobs);
+	p.n_chunks = 0;
+	p.pages = NULL;
+	p.history = NULL;
+	p.failed = 0;
+
+	if (pthread_create(&pager, NULL, retrieve_history, &p)) {
+		log_err(_("Failed to create thread"));
+		queue_free(p.todo);
+		queue_free(p.done);
+		return NULL;
+	}
+
+	if (pthread_create(&aggregators, NULL, run_aggregators, &p)) {
+		log_err(_("Failed to create thread"));
+
+		/* the retrieval is drained before giving up */
+		while ((c = queue_pop(p.todo)))
+			free(c);
+		pthread_join(pager, NULL);
+
+		queue_free(p.todo);
+		queue_free(p.done);
+		pipeline_free_history(&p);
+		return NULL;
 	}
 
 	ppa = ppa_stats_new(owner, ppa_name);
 
-	for (h_cur = history; *h_cur; ++h_cur) {
-		h = *h_cur;
-		totals = get_daily_download_totals(h->self_link,
-						   h->date_created);
-		if (!totals) {
-			log_err(_("Failed to retrieve download totals for %s"),
-				h->self_link);
+	/* chunks aggregated before the previous ones, indexed by seq */
+	pending = NULL;
+	n_pending = 0;
+	next = 0;
+	failed = 0;
+
+	/* after a failure, the chunks are only drained */
+	while ((c = queue_pop(p.done))) {
+		if (failed) {
+			chunk_free(c);
 			continue;
 		}
-		count = ddts_get_count(totals);
-		pkg_name = h->binary_package_name;
-		pkg_version = h->binary_package_version;
-		arch_series
-			= get_distro_arch_series(h->distro_arch_series_link);
-		distro_series
-			= get_distro_series(arch_series->distroseries_link);
-
-		ppa->download_count += count;
-		tmp = add_totals(ppa->daily_download_totals, totals);
-		if (ppa->daily_download_totals != tmp)
-			free(ppa->daily_download_totals);
-		ppa->daily_download_totals = tmp;
-
-		pkg = get_package_stats(ppa, pkg_name);
-		pkg->download_count += count;
-		tmp = add_totals(pkg->daily_download_totals, totals);
-		if (pkg->daily_download_totals != tmp)
-			free(pkg->daily_download_totals);
-		pkg->daily_download_totals = tmp;
-
-		version = get_version_stats(pkg, pkg_version);
-		version->date_created = h->date_created;
-
-		version->download_count += count;
-		tmp = add_totals(version->daily_download_totals, totals);
-		if (version->daily_download_totals != tmp)
-			free(version->daily_download_totals);
-		version->daily_download_totals = tmp;
-
-		distro = get_distro_stats(version, distro_series->name);
-		distro->download_count += count;
-
-		arch = get_arch_stats(distro, arch_series->architecture_tag);
-		arch->download_count += count;
-
-		pkg_add_distro(pkg, distro_series->name, count, totals);
 
-		daily_download_total_list_free(totals);
+		if (c->seq >= n_pending) {
+			n = 2 * c->seq + 1;
+			chunks = realloc(pending, n * sizeof(struct chunk *));
+			if (!chunks) {
+				chunk_free(c);
+				failed = 1;
+				continue;
+			}
+			pending = chunks;
+			memset(pending + n_pending,
+			       0,
+			       (n - n_pending) * sizeof(struct chunk *));
+			n_pending = n;
+		}
+		pending[c->seq] = c;
+
+		while (next < n_pending && pending[next]) {
+			c = pending[next];
+			if (!c->partial)
+				failed = 1;
+			else if (!failed && ppa_stats_merge(ppa, c->partial))
+				failed = 1;
+			chunk_free(c);
+			pending[next] = NULL;
+			next++;
+		}
 	}
 
-	bpph_list_free(history);
+	pthread_join(pager, NULL);
+	pthread_join(aggregators, NULL);
+
+	for (; next < n_pending; next++)
+		if (pending[next])
+			chunk_free(pending[next]);
+	free(pending);
+	queue_free(p.todo);
+	queue_free(p.done);
+
+	if (!p.history)
+		log_err(_("Failed to retrieve the PPA %s/%s"), owner, ppa_name);
+	else if (failed || p.failed)
+		log_err(_("Failed to aggregate the PPA %s/%s"),
+			owner,
+			ppa_name);
+
+	if (!p.history || failed || p.failed) {
+		pipeline_free_history(&p);
+		ppa_stats_free(ppa);
+		return NULL;
+	}
+
+	pipeline_free_history(&p);
+
+	ppa_stats_index(ppa);
 
 	return ppa;
 }
@@ -431,13 +873,29 @@ void ppa_stats_free(struct ppa_stats *ppastats)
 			package_stats_free(*packages);
 			packages++;
 		}
-		free(ppastats->packages);
+		vector_free((void **)ppastats->packages);
 	}
 
 	free(ppastats->owner);
 	free(ppastats->name);
 
 	daily_download_total_list_free(ppastats->daily_download_totals);
+	series_free(ppastats->series);
 
 	free(ppastats);
 }
+
+struct daily_download_total **ppa_stats_sum_ddts(struct ppa_stats **ppas)
+{
+	struct daily_download_total **ddts;
+
+	ddts = NULL;
+	for (; *ppas; ppas++)
+		if (add_totals(&ddts, (*ppas)->daily_download_totals)) {
+			log_err(_("Failed to sum the download totals"));
+			daily_download_total_list_free(ddts);
+			return NULL;
+		}
+
+	return ddts;
+}
@@ -21,6 +21,7 @@
 #define _PPASTATS_PPASTATS_H_
 
 #include "lp.h"
+#include "series.h"
 
 struct arch_stats {
 	char *name;
@@ -34,6 +35,7 @@ struct distro_stats {
 	struct arch_stats **archs;
 	int download_count;
 	struct daily_download_total **ddts;
+	struct series *series;
 };
 
 struct version_stats {
@@ -43,6 +45,7 @@ struct version_stats {
 	struct distro_stats **distros;
 	int download_count;
 	struct daily_download_total **daily_download_totals;
+	struct series *series;
 };
 
 struct package_stats {
@@ -52,6 +55,7 @@ struct package_stats {
 	int download_count;
 	struct daily_download_total **daily_download_totals;
 	struct distro_stats **distros;
+	struct series *series;
 };
 
 struct ppa_stats {
@@ -61,15 +65,32 @@ struct ppa_stats {
 	struct package_stats **packages;
 	int download_count;
 	struct daily_download_total **daily_download_totals;
+	struct series *series;
 };
 
 /*
+ * The series of the PPA, of its packages, of their versions and of
+ * their distributions hold the prefix sums of their daily download
+ * totals, built once the aggregation is done. The distributions of a
+ * version only hold download counts.
+ *
  * 'ws_size': size of the reply array of the getPublishedBinaries request.
+ * 'jobs': maximum number of threads used to aggregate the statistics.
+ *
+ * Returns NULL if the PPA could not be retrieved or has no binary
+ * package of the requested status.
  */
 struct ppa_stats *create_ppa_stats(const char *owner,
 				   const char *ppa,
 				   const char *package_status,
-				   int ws_size);
+				   int ws_size,
+				   int jobs);
 void ppa_stats_free(struct ppa_stats *ppastats);
 
+/*
+ * Returns the daily download totals of several PPAs, 'ppas' is a
+ * NULL-terminated vector.
+ */
+struct daily_download_total **ppa_stats_sum_ddts(struct ppa_stats **ppas);
+
 #endif
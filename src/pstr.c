@@ -17,6 +17,7 @@
  02110-1301 USA
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <pstr.h>
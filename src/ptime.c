@@ -21,40 +21,123 @@
 
 #include <ptime.h>
 
-const int P_TIME_VER = 2;
+const int P_TIME_VER = 3;
 
-static const int ISO8601_TIME_LENGTH = 19; /* YYYY-MM-DDThh:mm:ss */
-static const int ISO8601_DATE_LENGTH = 10; /* YYYY-MM-DD */
+/* Writes the 'n' last digits of 'v'. */
+static void format_digits(char *buf, int v, int n)
+{
+	while (n--) {
+		buf[n] = '0' + v % 10;
+		v /= 10;
+	}
+}
 
-char *time_to_ISO8601_time(time_t *t)
+char *tm_to_ISO8601_date_r(const struct tm *tm, char *buf)
 {
-	struct tm lt;
+	int year;
 
-	memset(&lt, 0, sizeof(struct tm));
-	if (!gmtime_r(t, &lt))
+	year = tm->tm_year + 1900;
+	if (year < 0 || year > 9999)
 		return NULL;
 
-	return tm_to_ISO8601_time(&lt);
+	format_digits(buf, year, 4);
+	buf[4] = '-';
+	format_digits(buf + 5, tm->tm_mon + 1, 2);
+	buf[7] = '-';
+	format_digits(buf + 8, tm->tm_mday, 2);
+	buf[10] = '\0';
+
+	return buf;
 }
 
-char *time_to_ISO8601_date(time_t *t)
+char *tm_to_ISO8601_time_r(const struct tm *tm, char *buf)
 {
-	struct tm lt;
+	if (!tm_to_ISO8601_date_r(tm, buf))
+		return NULL;
+
+	buf[10] = 'T';
+	format_digits(buf + 11, tm->tm_hour, 2);
+	buf[13] = ':';
+	format_digits(buf + 14, tm->tm_min, 2);
+	buf[16] = ':';
+	format_digits(buf + 17, tm->tm_sec, 2);
+	buf[19] = '\0';
+
+	return buf;
+}
+
+char *time_to_ISO8601_time_r(time_t t, char *buf)
+{
+	struct tm tm;
+
+	utc_time_to_tm(t, &tm);
+
+	return tm_to_ISO8601_time_r(&tm, buf);
+}
 
-	memset(&lt, 0, sizeof(struct tm));
-	if (!gmtime_r(t, &lt))
+char *time_to_ISO8601_date_r(time_t t, char *buf)
+{
+	struct tm tm;
+
+	utc_time_to_tm(t, &tm);
+
+	return tm_to_ISO8601_date_r(&tm, buf);
+}
+
+char *get_current_ISO8601_time_r(char *buf)
+{
+	static __thread time_t last_t = -1;
+	static __thread char last_str[ISO8601_TIME_SIZE];
+	time_t t;
+
+	t = time(NULL);
+
+	if (t != last_t) {
+		if (!time_to_ISO8601_time_r(t, last_str))
+			return NULL;
+		last_t = t;
+	}
+
+	memcpy(buf, last_str, ISO8601_TIME_SIZE);
+
+	return buf;
+}
+
+char *time_to_ISO8601_time(time_t *t)
+{
+	char *str;
+
+	str = malloc(ISO8601_TIME_SIZE);
+
+	if (time_to_ISO8601_time_r(*t, str)) {
+		return str;
+	} else {
+		free(str);
 		return NULL;
+	}
+}
+
+char *time_to_ISO8601_date(time_t *t)
+{
+	char *str;
+
+	str = malloc(ISO8601_DATE_SIZE);
 
-	return tm_to_ISO8601_date(&lt);
+	if (time_to_ISO8601_date_r(*t, str)) {
+		return str;
+	} else {
+		free(str);
+		return NULL;
+	}
 }
 
 char *tm_to_ISO8601_date(struct tm *tm)
 {
 	char *str;
 
-	str = malloc(ISO8601_DATE_LENGTH + 1);
+	str = malloc(ISO8601_DATE_SIZE);
 
-	if (strftime(str, ISO8601_DATE_LENGTH + 1, "%F", tm)) {
+	if (tm_to_ISO8601_date_r(tm, str)) {
 		return str;
 	} else {
 		free(str);
@@ -66,9 +149,9 @@ char *tm_to_ISO8601_time(struct tm *tm)
 {
 	char *str;
 
-	str = malloc(ISO8601_TIME_LENGTH + 1);
+	str = malloc(ISO8601_TIME_SIZE);
 
-	if (strftime(str, ISO8601_TIME_LENGTH + 1, "%FT%T", tm)) {
+	if (tm_to_ISO8601_time_r(tm, str)) {
 		return str;
 	} else {
 		free(str);
@@ -83,3 +166,185 @@ char *get_current_ISO8601_time()
 	t = time(NULL);
 	return time_to_ISO8601_time(&t);
 }
+
+/* Parses 'n' digits, returns -1 if one is missing. */
+static int parse_digits(const char *str, int n)
+{
+	int i, v;
+
+	v = 0;
+	for (i = 0; i < n; i++) {
+		if (str[i] < '0' || str[i] > '9')
+			return -1;
+
+		v = 10 * v + str[i] - '0';
+	}
+
+	return v;
+}
+
+int ISO8601_date_to_tm(const char *str, struct tm *tm)
+{
+	int y, m, d;
+
+	y = parse_digits(str, 4);
+	if (y == -1 || str[4] != '-')
+		return -1;
+
+	m = parse_digits(str + 5, 2);
+	if (m < 1 || m > 12 || str[7] != '-')
+		return -1;
+
+	d = parse_digits(str + 8, 2);
+	if (d < 1 || d > 31)
+		return -1;
+
+	tm->tm_year = y - 1900;
+	tm->tm_mon = m - 1;
+	tm->tm_mday = d;
+
+	return 0;
+}
+
+int ISO8601_time_to_time(const char *str, time_t *t)
+{
+	struct tm tm;
+	int offset, h, m;
+
+	memset(&tm, 0, sizeof(struct tm));
+
+	if (ISO8601_date_to_tm(str, &tm) || str[10] != 'T')
+		return -1;
+
+	str += 11;
+
+	tm.tm_hour = parse_digits(str, 2);
+	if (tm.tm_hour < 0 || tm.tm_hour > 23 || str[2] != ':')
+		return -1;
+
+	tm.tm_min = parse_digits(str + 3, 2);
+	if (tm.tm_min < 0 || tm.tm_min > 59 || str[5] != ':')
+		return -1;
+
+	tm.tm_sec = parse_digits(str + 6, 2);
+	if (tm.tm_sec < 0 || tm.tm_sec > 60)
+		return -1;
+
+	str += 8;
+
+	if (*str == '.')
+		do {
+			str++;
+		} while (*str >= '0' && *str <= '9');
+
+	offset = 0;
+	if (*str == '+' || *str == '-') {
+		h = parse_digits(str + 1, 2);
+		if (h == -1)
+			return -1;
+
+		if (str[3] == ':')
+			m = parse_digits(str + 4, 2);
+		else
+			m = parse_digits(str + 3, 2);
+		if (m == -1)
+			return -1;
+
+		offset = h * 60 * 60 + m * 60;
+		if (*str == '-')
+			offset = -offset;
+	}
+
+	*t = tm_to_utc_time(&tm) - offset;
+
+	return 0;
+}
+
+long date_to_days(int year, int month, int day)
+{
+	long era, yoe, doy, doe;
+
+	/* years starting in March, the leap day is the last one */
+	if (month <= 2)
+		year--;
+
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	/* 719468: days from 0000-03-01 to 1970-01-01 */
+	return era * 146097 + doe - 719468;
+}
+
+void days_to_date(long days, int *year, int *month, int *day)
+{
+	long era, doe, yoe, doy, mp;
+
+	days += 719468;
+
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	doe = days - era * 146097;
+	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	mp = (5 * doy + 2) / 153;
+
+	*day = doy - (153 * mp + 2) / 5 + 1;
+	*month = mp < 10 ? mp + 3 : mp - 9;
+	*year = yoe + era * 400 + (*month <= 2);
+}
+
+time_t tm_to_utc_time(const struct tm *tm)
+{
+	long year, mon, days;
+
+	year = tm->tm_year + 1900L + tm->tm_mon / 12;
+	mon = tm->tm_mon % 12;
+	if (mon < 0) {
+		mon += 12;
+		year--;
+	}
+
+	days = date_to_days(year, mon + 1, 1) + tm->tm_mday - 1;
+
+	return (time_t)days * 24 * 60 * 60
+		+ tm->tm_hour * 60 * 60
+		+ tm->tm_min * 60
+		+ tm->tm_sec;
+}
+
+void utc_time_to_tm(time_t t, struct tm *tm)
+{
+	long days, secs;
+	int year, month, day;
+
+	days = t / (24 * 60 * 60);
+	secs = t % (24 * 60 * 60);
+	if (secs < 0) {
+		secs += 24 * 60 * 60;
+		days--;
+	}
+
+	days_to_date(days, &year, &month, &day);
+
+	memset(tm, 0, sizeof(struct tm));
+
+	tm->tm_year = year - 1900;
+	tm->tm_mon = month - 1;
+	tm->tm_mday = day;
+	tm->tm_hour = secs / (60 * 60);
+	tm->tm_min = secs / 60 % 60;
+	tm->tm_sec = secs % 60;
+	/* 1970-01-01 is a Thursday */
+	tm->tm_wday = (days % 7 + 11) % 7;
+	tm->tm_yday = days - date_to_days(year, 1, 1);
+}
+
+double get_monotonic_time()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -23,6 +23,10 @@
 
 extern const int P_TIME_VER;
 
+/* Sizes of the 'YYYY-MM-DDThh:mm:ss' and 'YYYY-MM-DD' strings. */
+#define ISO8601_TIME_SIZE 20
+#define ISO8601_DATE_SIZE 11
+
 char *get_current_ISO8601_time();
 
 char *time_to_ISO8601_time(time_t *);
@@ -31,4 +35,61 @@ char *time_to_ISO8601_date(time_t *);
 char *tm_to_ISO8601_date(struct tm *);
 char *tm_to_ISO8601_time(struct tm *);
 
+/*
+ * Variants of the functions above formatting into 'buf' which must be
+ * ISO8601_TIME_SIZE or ISO8601_DATE_SIZE long.
+ *
+ * Return 'buf' or NULL if the year has not 4 digits.
+ */
+char *tm_to_ISO8601_time_r(const struct tm *tm, char *buf);
+char *tm_to_ISO8601_date_r(const struct tm *tm, char *buf);
+char *time_to_ISO8601_time_r(time_t t, char *buf);
+char *time_to_ISO8601_date_r(time_t t, char *buf);
+
+/*
+ * Formats the current time into 'buf'. The formatting is done once
+ * per second and per thread.
+ */
+char *get_current_ISO8601_time_r(char *buf);
+
+/*
+ * Parses a 'YYYY-MM-DDThh:mm:ss' time, optionally followed by
+ * fractional seconds and by a 'Z' or '+hh:mm' UTC offset. A time
+ * without offset is in UTC.
+ *
+ * Returns 0 on success, else -1.
+ */
+int ISO8601_time_to_time(const char *str, time_t *t);
+
+/*
+ * Parses the 'YYYY-MM-DD' date starting 'str', only the tm_year,
+ * tm_mon and tm_mday fields are set.
+ *
+ * Returns 0 on success, else -1.
+ */
+int ISO8601_date_to_tm(const char *str, struct tm *tm);
+
+/*
+ * Conversions between a date of the proleptic Gregorian calendar and
+ * the number of days since 1970-01-01. 'month' is in 1-12.
+ */
+long date_to_days(int year, int month, int day);
+void days_to_date(long days, int *year, int *month, int *day);
+
+/*
+ * Returns the time of a broken-down UTC time like timegm(): tm_wday,
+ * tm_yday and tm_isdst are ignored, the other fields may be out of
+ * their range. Unlike mktime(), the timezone is not involved.
+ */
+time_t tm_to_utc_time(const struct tm *tm);
+
+/* Breaks down a time in UTC like gmtime_r(). */
+void utc_time_to_tm(time_t t, struct tm *tm);
+
+/*
+ * Returns the time in seconds of a monotonic clock, for measuring
+ * durations.
+ */
+double get_monotonic_time();
+
 #endif
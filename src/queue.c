@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <queue.h>
+
+struct queue {
+	void **items;
+	int capacity;
+	int head;
+	int size;
+	int closed;
+
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+};
+
+struct queue *queue_new(int capacity)
+{
+	struct queue *q;
+
+	if (capacity < 1)
+		capacity = 1;
+
+	q = malloc(sizeof(struct queue));
+	q->items = malloc(capacity * sizeof(void *));
+	q->capacity = capacity;
+	q->head = 0;
+	q->size = 0;
+	q->closed = 0;
+
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->not_empty, NULL);
+	pthread_cond_init(&q->not_full, NULL);
+
+	return q;
+}
+
+void queue_free(struct queue *q)
+{
+	if (q) {
+		pthread_mutex_destroy(&q->lock);
+		pthread_cond_destroy(&q->not_empty);
+		pthread_cond_destroy(&q->not_full);
+
+		free(q->items);
+		free(q);
+	}
+}
+
+void queue_push(struct queue *q, void *item)
+{
+	pthread_mutex_lock(&q->lock);
+
+	while (q->size == q->capacity)
+		pthread_cond_wait(&q->not_full, &q->lock);
+
+	q->items[(q->head + q->size) % q->capacity] = item;
+	q->size++;
+
+	pthread_cond_signal(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+}
+
+void *queue_pop(struct queue *q)
+{
+	void *item;
+
+	pthread_mutex_lock(&q->lock);
+
+	while (!q->size && !q->closed)
+		pthread_cond_wait(&q->not_empty, &q->lock);
+
+	if (q->size) {
+		item = q->items[q->head];
+		q->head = (q->head + 1) % q->capacity;
+		q->size--;
+
+		pthread_cond_signal(&q->not_full);
+	} else {
+		item = NULL;
+	}
+
+	pthread_mutex_unlock(&q->lock);
+
+	return item;
+}
+
+void queue_close(struct queue *q)
+{
+	pthread_mutex_lock(&q->lock);
+
+	q->closed = 1;
+	pthread_cond_broadcast(&q->not_empty);
+
+	pthread_mutex_unlock(&q->lock);
+}
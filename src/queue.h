@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_QUEUE_H_
+#define _PPASTATS_QUEUE_H_
+
+/*
+ * Bounded FIFO queue of pointers shared between threads.
+ */
+struct queue;
+
+struct queue *queue_new(int capacity);
+
+void queue_free(struct queue *q);
+
+/* Adds an item, waits while the queue is full. 'item' must not be NULL. */
+void queue_push(struct queue *q, void *item);
+
+/*
+ * Removes the oldest item, waits while the queue is empty.
+ *
+ * Returns NULL when the queue is empty and closed.
+ */
+void *queue_pop(struct queue *q);
+
+/* Notifies the consumers that no more items will be pushed. */
+void queue_close(struct queue *q);
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <libintl.h>
+#define _(String) gettext(String)
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <lp_ws.h>
+#include <plog.h>
+#include <scheduler.h>
+#include <workers.h>
+
+static int max_refreshes;
+static int max_seconds;
+static time_t start;
+
+/* Number of refreshes already granted to the processed PPAs. */
+static int refreshes;
+static pthread_mutex_t refreshes_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct candidate {
+	int row;
+	/* 0 if the download totals have never been retrieved */
+	int retrieved;
+	struct ddts_state state;
+};
+
+struct refresh {
+	const struct bpph_table *history;
+	struct candidate *candidates;
+};
+
+void scheduler_set_budget(int refreshes, int seconds)
+{
+	max_refreshes = refreshes;
+	max_seconds = seconds;
+	start = time(NULL);
+}
+
+void scheduler_restart()
+{
+	pthread_mutex_lock(&refreshes_lock);
+	refreshes = 0;
+	start = time(NULL);
+	pthread_mutex_unlock(&refreshes_lock);
+}
+
+int scheduler_is_enabled()
+{
+	return max_refreshes > 0 || max_seconds > 0;
+}
+
+static int candidate_cmp(const void *o1, const void *o2)
+{
+	const struct candidate *c1, *c2;
+
+	c1 = o1;
+	c2 = o2;
+
+	if (c1->retrieved != c2->retrieved)
+		return c1->retrieved - c2->retrieved;
+
+	if (c1->state.velocity != c2->state.velocity)
+		return c2->state.velocity > c1->state.velocity ? 1 : -1;
+
+	if (c1->state.refreshed != c2->state.refreshed)
+		return c1->state.refreshed < c2->state.refreshed ? -1 : 1;
+
+	return c1->row - c2->row;
+}
+
+static void refresh_candidate(int i, void *data)
+{
+	struct refresh *r;
+	const struct bpph_table *h;
+	int row;
+
+	if (max_seconds > 0 && time(NULL) - start >= max_seconds)
+		return ;
+
+	r = data;
+	h = r->history;
+	row = r->candidates[i].row;
+
+	daily_download_total_list_free
+		(get_daily_download_totals(bpph_get_self_link(h, row),
+					   h->date_created[row],
+					   bpph_get_date_frozen(h, row),
+					   1));
+}
+
+void scheduler_refresh(const struct bpph_table *history, int jobs)
+{
+	struct refresh r;
+	struct candidate *c;
+	time_t now, frozen;
+	int i, n;
+
+	if (!history || !history->length)
+		return ;
+
+	now = time(NULL);
+
+	r.history = history;
+	r.candidates = malloc(history->length * sizeof(struct candidate));
+	if (!r.candidates) {
+		log_err(_("Failed to schedule the download totals refreshes"));
+		return ;
+	}
+
+	n = 0;
+	for (i = 0; i < history->length; i++) {
+		c = &r.candidates[n];
+		c->row = i;
+
+		if (get_ddts_state(bpph_get_self_link(history, i), &c->state)) {
+			c->retrieved = 0;
+			c->state.velocity = 0;
+			c->state.refreshed = 0;
+			n++;
+			continue;
+		}
+		c->retrieved = 1;
+
+		frozen = bpph_get_date_frozen(history, i);
+		if (frozen > 0
+		    && c->state.finalized >= frozen / (24 * 60 * 60))
+			continue;
+
+		if (now < c->state.refreshed + c->state.interval)
+			continue;
+
+		n++;
+	}
+
+	qsort(r.candidates, n, sizeof(struct candidate), candidate_cmp);
+
+	if (max_refreshes > 0) {
+		pthread_mutex_lock(&refreshes_lock);
+		if (n > max_refreshes - refreshes)
+			n = max_refreshes - refreshes;
+		refreshes += n;
+		pthread_mutex_unlock(&refreshes_lock);
+	}
+
+	log_debug(_("refreshing the download totals of %d binaries"), n);
+
+	workers_run(n, jobs, refresh_candidate, &r);
+
+	free(r.candidates);
+}
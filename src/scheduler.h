@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_SCHEDULER_H_
+#define _PPASTATS_SCHEDULER_H_
+
+#include "lp.h"
+
+/*
+ * Refresh scheduling of the download totals.
+ *
+ * Without budget, the download totals of all the binaries are
+ * refreshed. With a budget, they are refreshed before the aggregation
+ * in the order of priority until the budget is exhausted: first the
+ * binaries never retrieved, then the others by decreasing velocity.
+ * The quiet binaries are not refreshed before the end of their
+ * retrieval delay. The aggregation uses the cached totals.
+ *
+ * The budget is shared by all the PPAs processed by the process.
+ */
+
+/*
+ * Sets the budget: the maximal number of binaries whose download totals
+ * are refreshed and the maximal number of seconds from now during which
+ * they are refreshed. 0 for no limit.
+ */
+void scheduler_set_budget(int max_refreshes, int max_seconds);
+
+/*
+ * Starts a new budget period with the same limits, for each refresh
+ * cycle of the daemon.
+ */
+void scheduler_restart();
+
+/* Returns 1 if a budget has been set. */
+int scheduler_is_enabled();
+
+/*
+ * Refreshes within the budget the download totals of the binaries of
+ * 'history' using 'jobs' threads.
+ */
+void scheduler_refresh(const struct bpph_table *history, int jobs);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ptime.h>
+#include <series.h>
+
+static long get_day(const struct daily_download_total *ddt)
+{
+	return date_to_days(ddt->date.tm_year + 1900,
+			    ddt->date.tm_mon + 1,
+			    ddt->date.tm_mday);
+}
+
+struct series *series_new(struct daily_download_total **ddts)
+{
+	struct daily_download_total **cur;
+	struct series *s;
+	long day, last, i;
+
+	s = malloc(sizeof(struct series));
+	s->first_day = 0;
+	s->n_days = 0;
+
+	last = -1;
+	if (ddts && *ddts) {
+		s->first_day = get_day(*ddts);
+		last = s->first_day;
+
+		for (cur = ddts + 1; *cur; cur++) {
+			day = get_day(*cur);
+
+			if (day < s->first_day)
+				s->first_day = day;
+			else if (day > last)
+				last = day;
+		}
+
+		s->n_days = last - s->first_day + 1;
+	}
+
+	s->sums = calloc(s->n_days + 1, sizeof(long));
+
+	for (cur = ddts; cur && *cur; cur++)
+		s->sums[get_day(*cur) - s->first_day + 1] += (*cur)->count;
+
+	for (i = 1; i <= s->n_days; i++)
+		s->sums[i] += s->sums[i - 1];
+
+	return s;
+}
+
+void series_free(struct series *s)
+{
+	if (s) {
+		free(s->sums);
+		free(s);
+	}
+}
+
+long series_sum(const struct series *s, long from, long to)
+{
+	if (from < s->first_day)
+		from = s->first_day;
+
+	if (to > s->first_day + s->n_days - 1)
+		to = s->first_day + s->n_days - 1;
+
+	if (from > to)
+		return 0;
+
+	return s->sums[to - s->first_day + 1] - s->sums[from - s->first_day];
+}
+
+long series_sum_previous(const struct series *s, long from, long to)
+{
+	return series_sum(s, from - (to - from + 1), from - 1);
+}
+
+void series_rolling_sums(const struct series *s,
+			 long from,
+			 long to,
+			 int days,
+			 long *sums)
+{
+	long day;
+
+	for (day = from; day <= to; day++)
+		sums[day - from] = series_sum(s, day - days + 1, day);
+}
+
+int series_parse_day(const char *str, long *day)
+{
+	struct tm tm;
+	int y, m, d;
+
+	memset(&tm, 0, sizeof(struct tm));
+
+	if (strlen(str) != 10 || ISO8601_date_to_tm(str, &tm))
+		return -1;
+
+	*day = date_to_days(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+	/* rejects the days past the end of the month */
+	days_to_date(*day, &y, &m, &d);
+	if (d != tm.tm_mday)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_SERIES_H_
+#define _PPASTATS_SERIES_H_
+
+#include "lp.h"
+
+/*
+ * Prefix sums of daily download totals.
+ *
+ * Built once from the totals of an aggregated series, the sum of the
+ * downloads of any range of days is then computed in constant time.
+ * Days are numbered like date_to_days(), from 1970-01-01.
+ */
+struct series {
+	/* day of the oldest total */
+	long first_day;
+	/* number of days from the oldest total to the newest one */
+	long n_days;
+	/* sums[i] is the sum of the totals of the first i days */
+	long *sums;
+};
+
+/* Returns the prefix sums of 'ddts', which do not need to be sorted. */
+struct series *series_new(struct daily_download_total **ddts);
+
+void series_free(struct series *s);
+
+/*
+ * Returns the downloads from day 'from' to day 'to', both included.
+ * LONG_MIN and LONG_MAX can be used for open ranges.
+ */
+long series_sum(const struct series *s, long from, long to);
+
+/*
+ * Returns the downloads of the period of the same length just before
+ * the range [from, to], which must be bounded.
+ */
+long series_sum_previous(const struct series *s, long from, long to);
+
+/*
+ * Sets sums[i] to the downloads of the 'days' days ending on day
+ * 'from + i', for each day of the range [from, to], which must be
+ * bounded.
+ */
+void series_rolling_sums(const struct series *s,
+			 long from,
+			 long to,
+			 int days,
+			 long *sums);
+
+/* Returns the day of a YYYY-MM-DD date, or -1 if it is invalid. */
+int series_parse_day(const char *str, long *day);
+
+#endif
@@ -0,0 +1,754 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <libintl.h>
+#define _(String) gettext(String)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <json_writer.h>
+#include <list.h>
+#include <plog.h>
+#include <series.h>
+#include <server.h>
+
+/* maximum size of the request line and headers */
+#define REQUEST_MAX_SIZE 4096
+
+/* maximum size of the status line and headers of a reply */
+#define REPLY_HEADER_MAX_SIZE 256
+
+/* maximum number of clients served at once */
+#define MAX_CLIENTS 32
+
+static const int DEFAULT_TOP_SIZE = 10;
+
+/* seconds before giving up a client which does not read or write */
+static const int CLIENT_TIMEOUT = 5;
+
+static int listen_fd = -1;
+static pthread_t server_thread;
+static volatile int stopped;
+/* written by server_stop() to wake up the server thread */
+static int stop_pipe[2] = { -1, -1 };
+
+/* the published statistics, read by the server thread */
+static struct ppa_stats **published;
+static pthread_mutex_t published_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct query {
+	long from;
+	long to;
+	int n;
+};
+
+struct package_count {
+	const char *name;
+	long count;
+};
+
+struct client {
+	int fd;
+	char request[REQUEST_MAX_SIZE];
+	int request_len;
+	/* reply being sent, NULL while the request is read */
+	char *reply;
+	size_t reply_len;
+	size_t sent;
+	/* time after which the client is dropped if it stays idle */
+	time_t deadline;
+};
+
+/* the clients in progress, used by the server thread only */
+static struct client clients[MAX_CLIENTS];
+static int n_clients;
+
+/*
+ * Copies the value of 'key' from a query string into 'value'.
+ *
+ * Returns 1 if the key is present, 0 if absent or if its value does
+ * not fit into 'size' bytes.
+ */
+static int
+get_param(const char *params, const char *key, char *value, size_t size)
+{
+	const char *cur, *end;
+	size_t len;
+
+	len = strlen(key);
+
+	for (cur = params; cur && *cur; cur = end) {
+		end = strchr(cur, '&');
+		if (!end)
+			end = cur + strlen(cur);
+
+		if (!strncmp(cur, key, len) && cur[len] == '=') {
+			cur += len + 1;
+
+			if ((size_t)(end - cur) >= size)
+				return 0;
+
+			memcpy(value, cur, end - cur);
+			value[end - cur] = '\0';
+
+			return 1;
+		}
+
+		if (*end)
+			end++;
+	}
+
+	return 0;
+}
+
+static int parse_query(const char *params, struct query *q)
+{
+	char value[16];
+	char *end;
+
+	q->from = LONG_MIN;
+	q->to = LONG_MAX;
+	q->n = DEFAULT_TOP_SIZE;
+
+	if (get_param(params, "from", value, sizeof(value))
+	    && series_parse_day(value, &q->from))
+		return -1;
+
+	if (get_param(params, "to", value, sizeof(value))
+	    && series_parse_day(value, &q->to))
+		return -1;
+
+	if (get_param(params, "n", value, sizeof(value))) {
+		q->n = strtol(value, &end, 10);
+		if (*end || q->n < 1)
+			return -1;
+	}
+
+	return 0;
+}
+
+static struct ppa_stats *find_ppa(const char *owner, const char *name)
+{
+	struct ppa_stats **cur;
+
+	for (cur = published; cur && *cur; cur++)
+		if (!strcmp((*cur)->owner, owner)
+		    && !strcmp((*cur)->name, name))
+			return *cur;
+
+	return NULL;
+}
+
+static struct package_stats *
+find_package(struct ppa_stats *ppa, const char *name)
+{
+	struct package_stats **cur;
+
+	for (cur = ppa->packages; cur && *cur; cur++)
+		if (!strcmp((*cur)->name, name))
+			return *cur;
+
+	return NULL;
+}
+
+static void write_count(struct json_writer *w,
+			const char *name,
+			const struct series *s,
+			const struct query *q)
+{
+	json_write_object_begin(w);
+	json_write_key(w, "name");
+	json_write_string(w, name);
+	json_write_key(w, "count");
+	json_write_long(w, series_sum(s, q->from, q->to));
+	json_write_object_end(w);
+}
+
+static void write_ppa_header(struct json_writer *w,
+			     const struct ppa_stats *ppa,
+			     const struct query *q)
+{
+	json_write_key(w, "owner");
+	json_write_string(w, ppa->owner);
+	json_write_key(w, "name");
+	json_write_string(w, ppa->name);
+	json_write_key(w, "count");
+	json_write_long(w, series_sum(ppa->series, q->from, q->to));
+}
+
+static void write_ppas(struct json_writer *w, const struct query *q)
+{
+	struct ppa_stats **cur;
+
+	json_write_key(w, "ppas");
+	json_write_array_begin(w);
+	for (cur = published; cur && *cur; cur++) {
+		json_write_object_begin(w);
+		write_ppa_header(w, *cur, q);
+		json_write_object_end(w);
+	}
+	json_write_array_end(w);
+}
+
+static void write_packages(struct json_writer *w,
+			   const struct ppa_stats *ppa,
+			   const struct query *q)
+{
+	struct package_stats **cur;
+
+	write_ppa_header(w, ppa, q);
+
+	json_write_key(w, "packages");
+	json_write_array_begin(w);
+	for (cur = ppa->packages; cur && *cur; cur++)
+		write_count(w, (*cur)->name, (*cur)->series, q);
+	json_write_array_end(w);
+}
+
+static int package_count_cmp(const void *p1, const void *p2)
+{
+	const struct package_count *c1 = p1, *c2 = p2;
+
+	if (c1->count != c2->count)
+		return c1->count < c2->count ? 1 : -1;
+
+	return strcmp(c1->name, c2->name);
+}
+
+/* Returns 0 or -1 if the packages could not be sorted. */
+static int write_top(struct json_writer *w,
+		     const struct ppa_stats *ppa,
+		     const struct query *q)
+{
+	struct package_count *counts;
+	int i, n;
+
+	n = ppa->packages ? vector_length((void **)ppa->packages) : 0;
+
+	counts = NULL;
+	if (n) {
+		counts = malloc(n * sizeof(struct package_count));
+		if (!counts)
+			return -1;
+
+		for (i = 0; i < n; i++) {
+			counts[i].name = ppa->packages[i]->name;
+			counts[i].count
+				= series_sum(ppa->packages[i]->series,
+					     q->from,
+					     q->to);
+		}
+
+		qsort(counts,
+		      n,
+		      sizeof(struct package_count),
+		      package_count_cmp);
+	}
+
+	write_ppa_header(w, ppa, q);
+
+	json_write_key(w, "packages");
+	json_write_array_begin(w);
+	for (i = 0; i < n && i < q->n; i++) {
+		json_write_object_begin(w);
+		json_write_key(w, "name");
+		json_write_string(w, counts[i].name);
+		json_write_key(w, "count");
+		json_write_long(w, counts[i].count);
+		json_write_object_end(w);
+	}
+	json_write_array_end(w);
+
+	free(counts);
+
+	return 0;
+}
+
+static void write_distros(struct json_writer *w,
+			  const struct package_stats *pkg,
+			  const struct query *q)
+{
+	struct distro_stats **cur;
+
+	json_write_key(w, "name");
+	json_write_string(w, pkg->name);
+	json_write_key(w, "count");
+	json_write_long(w, series_sum(pkg->series, q->from, q->to));
+
+	json_write_key(w, "distros");
+	json_write_array_begin(w);
+	for (cur = pkg->distros; cur && *cur; cur++)
+		write_count(w, (*cur)->name, (*cur)->series, q);
+	json_write_array_end(w);
+}
+
+static int hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/*
+ * Decodes in place the %XX escapes of a path segment. Returns -1 if an
+ * escape is invalid or decodes to a NUL byte.
+ */
+static int percent_decode(char *seg)
+{
+	char *dst;
+	int hi, lo;
+
+	for (dst = seg; *seg; seg++) {
+		if (*seg != '%') {
+			*dst++ = *seg;
+			continue;
+		}
+
+		hi = hex_value(seg[1]);
+		lo = hi == -1 ? -1 : hex_value(seg[2]);
+		if (lo == -1 || (!hi && !lo))
+			return -1;
+
+		*dst++ = hi * 16 + lo;
+		seg += 2;
+	}
+	*dst = '\0';
+
+	return 0;
+}
+
+/*
+ * Writes the reply of the request of 'path' with the 'params' query
+ * string. The segments of the path are percent-decoded once split, an
+ * encoded '/' is part of a name. The published statistics must be
+ * locked.
+ *
+ * Returns the HTTP status code.
+ */
+static int answer(struct json_writer *w, char *path, const char *params)
+{
+	char *segs[5], *saveptr, *seg;
+	struct ppa_stats *ppa;
+	struct package_stats *pkg;
+	struct query q;
+	int i, n;
+
+	n = 0;
+	for (seg = strtok_r(path, "/", &saveptr);
+	     seg;
+	     seg = strtok_r(NULL, "/", &saveptr)) {
+		if (n == 5)
+			return 404;
+		segs[n++] = seg;
+	}
+
+	for (i = 0; i < n; i++)
+		if (percent_decode(segs[i]))
+			return 400;
+
+	if (!n || strcmp(segs[0], "ppas") || n == 2)
+		return 404;
+
+	if (parse_query(params, &q))
+		return 400;
+
+	json_write_object_begin(w);
+
+	if (n == 1) {
+		write_ppas(w, &q);
+	} else {
+		ppa = find_ppa(segs[1], segs[2]);
+		if (!ppa)
+			return 404;
+
+		if (n == 3) {
+			write_packages(w, ppa, &q);
+		} else if (n == 4 && !strcmp(segs[3], "top")) {
+			if (write_top(w, ppa, &q))
+				return 500;
+		} else if (n == 5 && !strcmp(segs[3], "packages")) {
+			pkg = find_package(ppa, segs[4]);
+			if (!pkg)
+				return 404;
+			write_distros(w, pkg, &q);
+		} else {
+			return 404;
+		}
+	}
+
+	json_write_object_end(w);
+
+	return 200;
+}
+
+static const char *get_reason(int status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	default:
+		return "Internal Server Error";
+	}
+}
+
+/* Prepares the reply of a client, returns 0 or -1 on failure. */
+static int set_reply(struct client *c, int status, const char *body)
+{
+	size_t size;
+
+	size = REPLY_HEADER_MAX_SIZE + strlen(body) + 1;
+	c->reply = malloc(size);
+	if (!c->reply)
+		return -1;
+
+	c->reply_len = snprintf(c->reply,
+				size,
+				"HTTP/1.0 %d %s\r\n"
+				"Content-Type: application/json\r\n"
+				"Content-Length: %zu\r\n"
+				"Connection: close\r\n"
+				"\r\n"
+				"%s",
+				status,
+				get_reason(status),
+				strlen(body),
+				body);
+	c->sent = 0;
+
+	return 0;
+}
+
+/*
+ * Reads what the client sent. Returns 1 once the request line and the
+ * headers are complete, 0 if they are not yet, or -1 if the client has
+ * to be dropped.
+ */
+static int read_request(struct client *c)
+{
+	ssize_t n;
+
+	n = recv(c->fd,
+		 c->request + c->request_len,
+		 REQUEST_MAX_SIZE - 1 - c->request_len,
+		 0);
+	if (n < 0 && (errno == EINTR || errno == EAGAIN))
+		return 0;
+	if (n <= 0)
+		return -1;
+
+	c->request_len += n;
+	c->request[c->request_len] = '\0';
+
+	if (strstr(c->request, "\r\n\r\n") || strstr(c->request, "\n\n"))
+		return 1;
+
+	return c->request_len < REQUEST_MAX_SIZE - 1 ? 0 : -1;
+}
+
+/*
+ * Sends the next part of the reply. Returns 1 once it is sent, 0 if it
+ * is not yet, or -1 on failure.
+ */
+static int send_reply(struct client *c)
+{
+	ssize_t n;
+
+	n = send(c->fd,
+		 c->reply + c->sent,
+		 c->reply_len - c->sent,
+		 MSG_NOSIGNAL);
+	if (n < 0)
+		return errno == EINTR || errno == EAGAIN ? 0 : -1;
+
+	c->sent += n;
+
+	return c->sent == c->reply_len;
+}
+
+/* Answers the request of a client, returns 0 or -1 on failure. */
+static int handle_client(struct client *c)
+{
+	char *method, *target, *params, *saveptr;
+	struct json_writer *w;
+	char *body;
+	int status, ret;
+
+	method = strtok_r(c->request, " \r\n", &saveptr);
+	target = method ? strtok_r(NULL, " \r\n", &saveptr) : NULL;
+
+	if (!target || *target != '/')
+		return set_reply(c, 400, "{ \"error\": \"invalid request\" }");
+
+	if (strcmp(method, "GET"))
+		return set_reply(c,
+				 405,
+				 "{ \"error\": \"method not allowed\" }");
+
+	params = strchr(target, '?');
+	if (params)
+		*params++ = '\0';
+
+	log_debug(_("server: GET %s"), target);
+
+	w = json_writer_new(JSON_WRITER_SPACED);
+
+	pthread_mutex_lock(&published_lock);
+	status = answer(w, target, params);
+	pthread_mutex_unlock(&published_lock);
+
+	body = json_writer_to_string(w);
+
+	if (status == 200)
+		ret = set_reply(c, status, body);
+	else if (status == 400)
+		ret = set_reply(c,
+				status,
+				"{ \"error\": \"invalid parameter\" }");
+	else if (status == 500)
+		ret = set_reply(c, status, "{ \"error\": \"internal error\" }");
+	else
+		ret = set_reply(c, status, "{ \"error\": \"not found\" }");
+
+	free(body);
+
+	return ret;
+}
+
+static void add_client(int fd)
+{
+	struct client *c;
+
+	if (fcntl(fd, F_SETFL, O_NONBLOCK)) {
+		close(fd);
+		return ;
+	}
+
+	c = &clients[n_clients++];
+	c->fd = fd;
+	c->request_len = 0;
+	c->reply = NULL;
+	c->deadline = time(NULL) + CLIENT_TIMEOUT;
+}
+
+/* Closes a client, the last one takes its slot. */
+static void drop_client(int i)
+{
+	close(clients[i].fd);
+	free(clients[i].reply);
+
+	n_clients--;
+	if (i != n_clients)
+		clients[i] = clients[n_clients];
+}
+
+/*
+ * The clients are served concurrently by polling their sockets, up to
+ * MAX_CLIENTS at once, the other ones wait in the backlog. The replies
+ * are computed in constant time per series and a client which neither
+ * reads nor writes is dropped after CLIENT_TIMEOUT seconds.
+ */
+static void *serve(void *arg)
+{
+	struct pollfd fds[2 + MAX_CLIENTS];
+	struct client *c;
+	time_t now;
+	int i, n, fd, ret;
+
+	while (!stopped) {
+		fds[0].fd = stop_pipe[0];
+		fds[0].events = POLLIN;
+		/* a negative descriptor is ignored by poll() */
+		fds[1].fd = n_clients < MAX_CLIENTS ? listen_fd : -1;
+		fds[1].events = POLLIN;
+
+		n = n_clients;
+		for (i = 0; i < n; i++) {
+			fds[2 + i].fd = clients[i].fd;
+			fds[2 + i].events = clients[i].reply ? POLLOUT : POLLIN;
+		}
+
+		if (poll(fds, 2 + n, 1000) == -1) {
+			if (errno != EINTR)
+				log_debug(_("server: poll failure"));
+			continue;
+		}
+
+		now = time(NULL);
+
+		/* backwards, a dropped client is replaced by the last one */
+		for (i = n - 1; i >= 0; i--) {
+			c = &clients[i];
+
+			if (!fds[2 + i].revents) {
+				if (now >= c->deadline) {
+					log_debug(_("server: client timeout"));
+					drop_client(i);
+				}
+				continue;
+			}
+
+			c->deadline = now + CLIENT_TIMEOUT;
+
+			if (c->reply) {
+				ret = send_reply(c);
+			} else {
+				ret = read_request(c);
+				if (ret == 1)
+					ret = handle_client(c);
+			}
+
+			if (ret)
+				drop_client(i);
+		}
+
+		if (fds[1].revents & POLLIN) {
+			fd = accept(listen_fd, NULL, NULL);
+
+			if (fd != -1)
+				add_client(fd);
+			else if (errno != EINTR && errno != EAGAIN)
+				log_debug(_("server: accept failure"));
+		}
+	}
+
+	while (n_clients)
+		drop_client(n_clients - 1);
+
+	return NULL;
+}
+
+int server_start(int port)
+{
+	struct sockaddr_in addr;
+	int on;
+
+	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd == -1) {
+		log_err(_("Failed to create the server socket"));
+		return -1;
+	}
+
+	on = 1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	memset(&addr, 0, sizeof(struct sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	/* accept() must not block if the client is gone meanwhile */
+	if (fcntl(listen_fd, F_SETFL, O_NONBLOCK)
+	    || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr))
+	    || listen(listen_fd, SOMAXCONN)) {
+		log_err(_("Failed to listen on the port %d"), port);
+		close(listen_fd);
+		listen_fd = -1;
+		return -1;
+	}
+
+	stopped = 0;
+	if (pipe(stop_pipe)
+	    || pthread_create(&server_thread, NULL, serve, NULL)) {
+		log_err(_("Failed to create thread"));
+		if (stop_pipe[0] != -1) {
+			close(stop_pipe[0]);
+			close(stop_pipe[1]);
+			stop_pipe[0] = stop_pipe[1] = -1;
+		}
+		close(listen_fd);
+		listen_fd = -1;
+		return -1;
+	}
+
+	log_debug(_("server: listening on the port %d"), port);
+
+	return 0;
+}
+
+void server_stop(void)
+{
+	if (listen_fd != -1) {
+		stopped = 1;
+
+		/* wakes up the server thread blocked in poll() */
+		if (write(stop_pipe[1], "", 1) != 1)
+			log_debug(_("server: failed to wake up the thread"));
+		pthread_join(server_thread, NULL);
+
+		close(stop_pipe[0]);
+		close(stop_pipe[1]);
+		stop_pipe[0] = stop_pipe[1] = -1;
+		close(listen_fd);
+		listen_fd = -1;
+	}
+
+	vector_free((void **)published);
+	published = NULL;
+}
+
+int server_publish(struct ppa_stats *old, struct ppa_stats *stats)
+{
+	struct ppa_stats **cur, **all;
+	int ret;
+
+	pthread_mutex_lock(&published_lock);
+
+	for (cur = published; old && cur && *cur; cur++)
+		if (*cur == old) {
+			*cur = stats;
+			break;
+		}
+
+	ret = 0;
+	if (!old || !cur || !*cur) {
+		all = (struct ppa_stats **)
+			vector_push((void **)published, stats);
+		if (all)
+			published = all;
+		else
+			ret = -1;
+	}
+
+	pthread_mutex_unlock(&published_lock);
+
+	return ret;
+}
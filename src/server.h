@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_SERVER_H_
+#define _PPASTATS_SERVER_H_
+
+#include "ppastats.h"
+
+/*
+ * Embedded HTTP server answering JSON queries on the statistics kept
+ * in memory, listening on the loopback interface only.
+ *
+ * The requests are answered from the published statistics and their
+ * prefix sums, without any file access:
+ *
+ *  /ppas                                totals of the PPAs
+ *  /ppas/OWNER/NAME                     totals of the packages of a PPA
+ *  /ppas/OWNER/NAME/top?n=N             the N most downloaded packages
+ *  /ppas/OWNER/NAME/packages/PACKAGE    totals of the distributions
+ *
+ * The optional 'from' and 'to' parameters, YYYY-MM-DD dates included
+ * in the range, restrict the totals to the downloads of a period.
+ */
+
+/* Starts the server thread, returns 0 or -1 on failure. */
+int server_start(int port);
+
+/* Stops the server thread, the clients in progress are dropped. */
+void server_stop(void);
+
+/*
+ * Replaces the published statistics 'old' by 'stats', or adds 'stats'
+ * if 'old' is NULL. 'old' is not used by the server anymore once the
+ * function returns and can be freed.
+ *
+ * Returns -1 if 'stats' cannot be added, it is then not published.
+ */
+int server_publish(struct ppa_stats *old, struct ppa_stats *stats);
+
+#endif
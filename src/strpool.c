@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hashmap.h>
+#include <strpool.h>
+
+struct strpool *strpool_new()
+{
+	struct strpool *pool;
+
+	pool = malloc(sizeof(struct strpool));
+
+	pool->blob_capacity = 1024;
+	pool->blob = malloc(pool->blob_capacity);
+	pool->blob_size = 0;
+
+	pool->offsets_capacity = 64;
+	pool->offsets = malloc(pool->offsets_capacity * sizeof(int));
+	pool->count = 0;
+
+	pool->index_capacity = 128;
+	pool->index = calloc(pool->index_capacity, sizeof(int));
+
+	return pool;
+}
+
+void strpool_free(struct strpool *pool)
+{
+	if (pool) {
+		free(pool->blob);
+		free(pool->offsets);
+		free(pool->index);
+		free(pool);
+	}
+}
+
+const char *strpool_get(const struct strpool *pool, int id)
+{
+	return pool->blob + pool->offsets[id];
+}
+
+/* Returns the slot of 'str' or of the empty slot where to insert it. */
+static int lookup(const struct strpool *pool, const char *str)
+{
+	int i, id;
+
+	i = hashmap_hash(str) & (pool->index_capacity - 1);
+	for (;;) {
+		id = pool->index[i] - 1;
+
+		if (id < 0 || !strcmp(strpool_get(pool, id), str))
+			return i;
+
+		i = (i + 1) & (pool->index_capacity - 1);
+	}
+}
+
+static void grow_index(struct strpool *pool)
+{
+	int id, i;
+
+	free(pool->index);
+
+	pool->index_capacity *= 2;
+	pool->index = calloc(pool->index_capacity, sizeof(int));
+
+	for (id = 0; id < pool->count; id++) {
+		i = lookup(pool, strpool_get(pool, id));
+		pool->index[i] = id + 1;
+	}
+}
+
+int strpool_find(const struct strpool *pool, const char *str)
+{
+	return pool->index[lookup(pool, str)] - 1;
+}
+
+int strpool_add(struct strpool *pool, const char *str)
+{
+	int i, len, id;
+
+	i = lookup(pool, str);
+	if (pool->index[i])
+		return pool->index[i] - 1;
+
+	len = strlen(str) + 1;
+	while (pool->blob_size + len > pool->blob_capacity) {
+		pool->blob_capacity *= 2;
+		pool->blob = realloc(pool->blob, pool->blob_capacity);
+	}
+
+	if (pool->count == pool->offsets_capacity) {
+		pool->offsets_capacity *= 2;
+		pool->offsets = realloc(pool->offsets,
+					pool->offsets_capacity * sizeof(int));
+	}
+
+	id = pool->count;
+	pool->offsets[id] = pool->blob_size;
+	memcpy(pool->blob + pool->blob_size, str, len);
+	pool->blob_size += len;
+	pool->count++;
+
+	pool->index[i] = id + 1;
+
+	/* keeps the load factor under 1/2 */
+	if (2 * pool->count > pool->index_capacity)
+		grow_index(pool);
+
+	return id;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef _PPASTATS_STRPOOL_H_
+#define _PPASTATS_STRPOOL_H_
+
+/*
+ * Pool of interned strings.
+ *
+ * Each distinct string is stored once in a contiguous blob and is
+ * identified by an id: ids are attributed in sequence from 0.
+ */
+struct strpool {
+	/* null-terminated strings, one after another */
+	char *blob;
+	int blob_size;
+	int blob_capacity;
+
+	/* offset in the blob of each string, indexed by id */
+	int *offsets;
+	int count;
+	int offsets_capacity;
+
+	/* open addressing hash table of 'id + 1', 0 for empty slots */
+	int *index;
+	int index_capacity;
+};
+
+struct strpool *strpool_new();
+
+void strpool_free(struct strpool *pool);
+
+/* Returns the id of 'str', adding it to the pool if needed. */
+int strpool_add(struct strpool *pool, const char *str);
+
+/* Returns the id of 'str' or -1 if it is not in the pool. */
+int strpool_find(const struct strpool *pool, const char *str);
+
+/*
+ * Returns the string of a given id. The pointer is valid until the
+ * next addition to the pool.
+ */
+const char *strpool_get(const struct strpool *pool, int id);
+
+#endif
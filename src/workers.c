@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 agent@local
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include <libintl.h>
+#define _(String) gettext(String)
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <plog.h>
+#include <workers.h>
+
+struct workers {
+	int n;
+	int next;
+
+	void (*fct)(int, void *);
+	void *data;
+
+	pthread_mutex_t lock;
+};
+
+static void *worker_loop(void *arg)
+{
+	struct workers *w;
+	int i;
+
+	w = arg;
+
+	for (;;) {
+		pthread_mutex_lock(&w->lock);
+		i = w->next;
+		if (i < w->n)
+			w->next++;
+		pthread_mutex_unlock(&w->lock);
+
+		if (i >= w->n)
+			break;
+
+		w->fct(i, w->data);
+	}
+
+	return NULL;
+}
+
+void workers_run(int n, int jobs, void (*fct)(int, void *), void *data)
+{
+	struct workers w;
+	pthread_t *threads;
+	int i, started;
+
+	if (jobs > n)
+		jobs = n;
+
+	if (jobs < 2) {
+		for (i = 0; i < n; i++)
+			fct(i, data);
+		return ;
+	}
+
+	w.n = n;
+	w.next = 0;
+	w.fct = fct;
+	w.data = data;
+	pthread_mutex_init(&w.lock, NULL);
+
+	threads = malloc((jobs - 1) * sizeof(pthread_t));
+
+	for (started = 0; started < jobs - 1; started++)
+		if (pthread_create(&threads[started], NULL, worker_loop, &w)) {
+			log_warn(_("Failed to create worker thread"));
+			break;
+		}
+
+	worker_loop(&w);
+
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+	pthread_mutex_destroy(&w.lock);
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2011-2015 jeanfi@gmail.com
+ * Copyright (C) 2015 jeanfi@gmail.com
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License as
@@ -17,14 +17,17 @@
  * 02110-1301 USA
  */
 
-#ifndef _PPASTATS_CACHE_H_
-#define _PPASTATS_CACHE_H_
+#ifndef _PPASTATS_WORKERS_H_
+#define _PPASTATS_WORKERS_H_
 
-const void *cache_get(const char *key);
-
-void cache_put(const char *key, const void *value,
-	       void (*fct_cleanup)(void *));
-
-void cache_cleanup();
+/*
+ * Calls 'fct(i, data)' for each 'i' in [0, n) using at most 'jobs'
+ * threads, the calling thread included. Indexes are handed out in
+ * increasing order to the first idle thread.
+ *
+ * Returns once all calls have completed. No thread is created when
+ * 'jobs' is lower than 2.
+ */
+void workers_run(int n, int jobs, void (*fct)(int, void *), void *data);
 
 #endif
@@ -0,0 +1,386 @@
+/*
+  Copyright (C) 2026 agent@local
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+/*
+ * Checks that the binary cache entries of recorded Launchpad replies
+ * are decoded to the encoded data and that damaged ones are rejected.
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <list.h>
+#include <lp_bin.h>
+#include <lp_parser.h>
+
+static char *load_payload(const char *name)
+{
+	const char *srcdir;
+	char *path, *content;
+	FILE *f;
+	long n;
+
+	srcdir = getenv("srcdir");
+	if (!srcdir)
+		srcdir = ".";
+
+	path = malloc(strlen(srcdir) + strlen("/data/") + strlen(name) + 1);
+	sprintf(path, "%s/data/%s", srcdir, name);
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Cannot open %s.\n", path);
+		exit(EXIT_FAILURE);
+	}
+	free(path);
+
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	content = malloc(n + 1);
+	if (fread(content, 1, n, f) != (size_t)n) {
+		fprintf(stderr, "Cannot read %s.\n", name);
+		exit(EXIT_FAILURE);
+	}
+	content[n] = '\0';
+
+	fclose(f);
+
+	return content;
+}
+
+static void add_entry(const struct bpph_entry *e, void *data)
+{
+	bpph_table_add(data,
+		       e->binary_package_name,
+		       e->binary_package_version,
+		       e->distro_arch_series_link,
+		       e->self_link,
+		       e->status,
+		       e->architecture_specific,
+		       e->date_created,
+		       e->date_superseded,
+		       e->date_removed);
+}
+
+static int bpph_table_cmp(const struct bpph_table *t1,
+			  const struct bpph_table *t2)
+{
+	int i;
+
+	if (t1->length != t2->length)
+		return 1;
+
+	for (i = 0; i < t1->length; i++)
+		if (strcmp(bpph_get_name(t1, i), bpph_get_name(t2, i))
+		    || strcmp(bpph_get_version(t1, i), bpph_get_version(t2, i))
+		    || strcmp(bpph_get_distro_arch_series_link(t1, i),
+			      bpph_get_distro_arch_series_link(t2, i))
+		    || strcmp(bpph_get_self_link(t1, i),
+			      bpph_get_self_link(t2, i))
+		    || strcmp(bpph_get_status(t1, i), bpph_get_status(t2, i))
+		    || t1->architecture_specific[i]
+		    != t2->architecture_specific[i]
+		    || t1->date_created[i] != t2->date_created[i]
+		    || t1->date_superseded[i] != t2->date_superseded[i]
+		    || t1->date_removed[i] != t2->date_removed[i])
+			return 1;
+
+	return 0;
+}
+
+static int tests_bpph()
+{
+	char *json, *next, *bin;
+	struct bpph_table *table, *decoded;
+	size_t size, n;
+	struct ddts_state state;
+	long synced;
+	int failures;
+
+	failures = 0;
+
+	json = load_payload("bpph_page.json");
+
+	table = bpph_table_new();
+	lp_parse_bpph_page(json, add_entry, table, &next, NULL);
+
+	if (is_lp_bin(json, strlen(json))) {
+		fprintf(stderr, "JSON entry detected as binary.\n");
+		failures++;
+	}
+
+	/* a known entry gets the status of the last one added */
+	bpph_table_add(table,
+		       bpph_get_name(table, 0),
+		       bpph_get_version(table, 0),
+		       bpph_get_distro_arch_series_link(table, 0),
+		       bpph_get_self_link(table, 0),
+		       "Deleted",
+		       table->architecture_specific[0],
+		       table->date_created[0],
+		       1392542321,
+		       0);
+	if (strcmp(bpph_get_status(table, 0), "Deleted")
+	    || bpph_get_date_frozen(table, 0) != 1392542321) {
+		fprintf(stderr, "bpph_table_add() status update failure.\n");
+		failures++;
+	}
+
+	decoded = bpph_table_filter(table, 0, table->length, "Deleted");
+	if (decoded->length != 1
+	    || strcmp(bpph_get_self_link(decoded, 0),
+		      bpph_get_self_link(table, 0))) {
+		fprintf(stderr, "bpph_table_filter() failure.\n");
+		failures++;
+	}
+	bpph_table_free(decoded);
+
+	decoded = bpph_table_filter(table, 1, table->length - 1, NULL);
+	if (decoded->length != table->length - 1) {
+		fprintf(stderr, "bpph_table_filter(NULL) failure.\n");
+		failures++;
+	}
+	bpph_table_free(decoded);
+
+	bin = bpph_table_to_bin(table, 16117, &size);
+
+	if (!is_lp_bin(bin, size)) {
+		fprintf(stderr, "bpph binary entry not detected.\n");
+		failures++;
+	}
+
+	synced = 0;
+	decoded = bin_to_bpph_table(bin, size, &synced);
+	if (!decoded
+	    || !table->length
+	    || bpph_table_cmp(table, decoded)
+	    || synced != 16117) {
+		fprintf(stderr, "bpph_table_to_bin() roundtrip failure.\n");
+		failures++;
+	}
+	bpph_table_free(decoded);
+
+	if (bin_to_ddts(bin, size, &state)) {
+		fprintf(stderr, "bpph entry decoded as ddts.\n");
+		failures++;
+	}
+
+	/* an older format version is rejected */
+	bin[4]--;
+	decoded = bin_to_bpph_table(bin, size, &synced);
+	if (decoded) {
+		fprintf(stderr, "bpph entry of another version decoded.\n");
+		bpph_table_free(decoded);
+		failures++;
+	}
+	bin[4]++;
+
+	for (n = 0; n < size; n++) {
+		decoded = bin_to_bpph_table(bin, n, &synced);
+		if (decoded) {
+			fprintf(stderr,
+				"truncated bpph entry %zu decoded.\n", n);
+			bpph_table_free(decoded);
+			failures++;
+			break;
+		}
+	}
+
+	free(bin);
+	bpph_table_free(table);
+	free(json);
+
+	return failures;
+}
+
+static int ddts_cmp(struct daily_download_total **ddts1,
+		    struct daily_download_total **ddts2)
+{
+	for (; *ddts1 && *ddts2; ddts1++, ddts2++)
+		if ((*ddts1)->count != (*ddts2)->count
+		    || (*ddts1)->date.tm_year != (*ddts2)->date.tm_year
+		    || (*ddts1)->date.tm_mon != (*ddts2)->date.tm_mon
+		    || (*ddts1)->date.tm_mday != (*ddts2)->date.tm_mday)
+			return 1;
+
+	return *ddts1 || *ddts2;
+}
+
+static int tests_ddts()
+{
+	char *json, *bin;
+	struct daily_download_total **ddts, **decoded;
+	size_t size, n;
+	struct ddts_state state, decoded_state;
+	int failures;
+
+	failures = 0;
+
+	json = load_payload("daily_download_totals.json");
+	ddts = lp_parse_daily_download_totals(json);
+
+	memset(&state, 0, sizeof(struct ddts_state));
+	state.finalized = 16117;
+	state.refreshed = 1392542321;
+	state.interval = 7200;
+	state.velocity = 42;
+	bin = ddts_to_bin(ddts, &state, &size);
+
+	memset(&decoded_state, 0, sizeof(struct ddts_state));
+	decoded = bin_to_ddts(bin, size, &decoded_state);
+	if (!decoded
+	    || !*ddts
+	    || ddts_cmp(ddts, decoded)
+	    || memcmp(&state, &decoded_state, sizeof(struct ddts_state))) {
+		fprintf(stderr, "ddts_to_bin() roundtrip failure.\n");
+		failures++;
+	}
+	daily_download_total_list_free(decoded);
+
+	memset(&decoded_state, 0, sizeof(struct ddts_state));
+	if (bin_to_ddts_state(bin, size, &decoded_state)
+	    || memcmp(&state, &decoded_state, sizeof(struct ddts_state))) {
+		fprintf(stderr, "bin_to_ddts_state() failure.\n");
+		failures++;
+	}
+
+	for (n = 0; n < size; n++) {
+		decoded = bin_to_ddts(bin, n, &decoded_state);
+		if (decoded) {
+			fprintf(stderr,
+				"truncated ddts entry %zu decoded.\n", n);
+			daily_download_total_list_free(decoded);
+			failures++;
+			break;
+		}
+	}
+
+	/* a newer format version is rejected */
+	bin[4]++;
+	decoded = bin_to_ddts(bin, size, &decoded_state);
+	if (decoded) {
+		fprintf(stderr, "ddts entry of another version decoded.\n");
+		daily_download_total_list_free(decoded);
+		failures++;
+	}
+
+	free(bin);
+	daily_download_total_list_free(ddts);
+	free(json);
+
+	return failures;
+}
+
+static int tests_distro_snapshot()
+{
+	char *json, *bin;
+	struct distro_snapshot *s, *decoded;
+	struct distro_arch_series *a, *da;
+	struct distro_series *d, *dd;
+	size_t size, n;
+	int failures;
+
+	failures = 0;
+
+	s = distro_snapshot_new(1392542321);
+
+	json = load_payload("distro_arch_series.json");
+	distro_snapshot_add_arch_series(s,
+					"https://api.launchpad.net/1.0/x/amd64",
+					lp_parse_distro_arch_series(json));
+	free(json);
+
+	json = load_payload("distro_series.json");
+	distro_snapshot_add_series(s,
+				   "https://api.launchpad.net/1.0/x",
+				   lp_parse_distro_series(json));
+	free(json);
+
+	bin = distro_snapshot_to_bin(s, &size);
+	decoded = bin_to_distro_snapshot(bin, size);
+
+	a = s->arch_series[0];
+	d = s->series[0];
+	if (!decoded
+	    || decoded->date != s->date
+	    || vector_length((void **)decoded->arch_series) != 1
+	    || vector_length((void **)decoded->series) != 1) {
+		fprintf(stderr,
+			"distro_snapshot_to_bin() roundtrip failure.\n");
+		failures++;
+	} else {
+		da = decoded->arch_series[0];
+		dd = decoded->series[0];
+		if (strcmp(decoded->arch_series_urls[0],
+			   s->arch_series_urls[0])
+		    || strcmp(da->display_name, a->display_name)
+		    || strcmp(da->title, a->title)
+		    || strcmp(da->architecture_tag, a->architecture_tag)
+		    || strcmp(da->distroseries_link, a->distroseries_link)
+		    || da->is_nominated_arch_indep
+		    != a->is_nominated_arch_indep
+		    || strcmp(decoded->series_urls[0], s->series_urls[0])
+		    || strcmp(dd->displayname, d->displayname)
+		    || strcmp(dd->name, d->name)
+		    || strcmp(dd->version, d->version)
+		    || strcmp(dd->title, d->title)) {
+			fprintf(stderr, "distro snapshot fields differ.\n");
+			failures++;
+		}
+	}
+	distro_snapshot_free(decoded, 1);
+
+	for (n = 0; n < size; n++) {
+		decoded = bin_to_distro_snapshot(bin, n);
+		if (decoded) {
+			fprintf(stderr,
+				"truncated distro snapshot %zu decoded.\n", n);
+			distro_snapshot_free(decoded, 1);
+			failures++;
+			break;
+		}
+	}
+
+	free(bin);
+	distro_snapshot_free(s, 1);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	int failures;
+
+	setenv("TZ", "UTC", 1);
+
+	failures = 0;
+
+	failures += tests_bpph();
+	failures += tests_ddts();
+	failures += tests_distro_snapshot();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
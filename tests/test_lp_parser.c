@@ -0,0 +1,630 @@
+/*
+  Copyright (C) 2026 agent@local
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+
+/*
+ * Checks the streaming parsers against json-c on recorded Launchpad
+ * replies and compares their speed.
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <json.h>
+
+#include <list.h>
+#include <lp_parser.h>
+
+/* Number of parsings of each reply for measuring the speed. */
+#define BENCH_ITERATIONS 200
+
+static char *load_payload(const char *name)
+{
+	const char *srcdir;
+	char *path, *content;
+	FILE *f;
+	long n;
+
+	srcdir = getenv("srcdir");
+	if (!srcdir)
+		srcdir = ".";
+
+	path = malloc(strlen(srcdir) + strlen("/data/") + strlen(name) + 1);
+	sprintf(path, "%s/data/%s", srcdir, name);
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Cannot open %s.\n", path);
+		exit(EXIT_FAILURE);
+	}
+	free(path);
+
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	rewind(f);
+
+	content = malloc(n + 1);
+	content[fread(content, 1, n, f)] = '\0';
+
+	fclose(f);
+
+	return content;
+}
+
+static double get_time_ms()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static time_t str_to_time(const char *str)
+{
+	struct tm tm;
+
+	if (!str)
+		return -1;
+
+	memset(&tm, 0, sizeof(struct tm));
+	tm.tm_isdst = -1;
+
+	if (strptime(str, "%FT%T", &tm))
+		return mktime(&tm);
+	else
+		return -1;
+}
+
+static const char *get_string(json_object *o, const char *key)
+{
+	json_object *j;
+
+	json_object_object_get_ex(o, key, &j);
+
+	return json_object_get_string(j);
+}
+
+static int get_boolean(json_object *o, const char *key)
+{
+	json_object *j;
+
+	json_object_object_get_ex(o, key, &j);
+
+	return json_object_get_boolean(j);
+}
+
+static int check_string(json_object *o, const char *key, const char *v)
+{
+	const char *ref;
+
+	ref = get_string(o, key);
+
+	if ((!ref && !v) || (ref && v && !strcmp(ref, v)))
+		return 0;
+
+	fprintf(stderr, "%s=%s instead of %s.\n", key, v, ref);
+
+	return 1;
+}
+
+static int check_int(const char *key, long v, long ref)
+{
+	if (v == ref)
+		return 0;
+
+	fprintf(stderr, "%s=%ld instead of %ld.\n", key, v, ref);
+
+	return 1;
+}
+
+/*
+ * Measures the average time of parsing 'payload' with 'json_c_parse'
+ * and 'lp_parse', the latter parses a copy as it is modified.
+ */
+static void bench(const char *name,
+		  const char *payload,
+		  void (*json_c_parse)(const char *payload),
+		  void (*lp_parse)(char *json))
+{
+	double t, t_json_c, t_lp;
+	char *buf;
+	int i;
+
+	buf = malloc(strlen(payload) + 1);
+
+	t = get_time_ms();
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+		json_c_parse(payload);
+	t_json_c = (get_time_ms() - t) / BENCH_ITERATIONS;
+
+	t = get_time_ms();
+	for (i = 0; i < BENCH_ITERATIONS; i++) {
+		strcpy(buf, payload);
+		lp_parse(buf);
+	}
+	t_lp = (get_time_ms() - t) / BENCH_ITERATIONS;
+
+	printf("%-28s json-c %8.4f ms  lp_parser %8.4f ms  x%.1f\n",
+	       name,
+	       t_json_c,
+	       t_lp,
+	       t_lp > 0 ? t_json_c / t_lp : 0);
+
+	free(buf);
+}
+
+struct entries {
+	struct bpph_entry *entries;
+	int n;
+};
+
+static void add_entry(const struct bpph_entry *e, void *data)
+{
+	struct entries *entries;
+
+	entries = data;
+
+	entries->entries = realloc(entries->entries,
+				   (entries->n + 1) * sizeof(*e));
+	entries->entries[entries->n] = *e;
+	entries->n++;
+}
+
+static int check_bpph_entry(json_object *o, const struct bpph_entry *e)
+{
+	int failures;
+
+	failures = 0;
+
+	failures += check_string(o,
+				 "binary_package_name",
+				 e->binary_package_name);
+	failures += check_string(o,
+				 "binary_package_version",
+				 e->binary_package_version);
+	failures += check_string(o,
+				 "distro_arch_series_link",
+				 e->distro_arch_series_link);
+	failures += check_string(o, "self_link", e->self_link);
+	failures += check_string(o, "status", e->status);
+	failures += check_int("architecture_specific",
+			      e->architecture_specific,
+			      get_boolean(o, "architecture_specific"));
+	failures += check_int("date_created",
+			      e->date_created,
+			      str_to_time(get_string(o, "date_created")));
+
+	return failures;
+}
+
+static int test_bpph_page()
+{
+	char *payload, *buf, *next;
+	json_object *json, *o_entries, *o_total_size;
+	struct entries entries;
+	int i, failures, total_size;
+
+	payload = load_payload("bpph_page.json");
+	json = json_tokener_parse(payload);
+
+	buf = strdup(payload);
+	entries.entries = NULL;
+	entries.n = 0;
+
+	if (lp_parse_bpph_page(buf, add_entry, &entries, &next, &total_size)) {
+		fprintf(stderr, "Failed to parse bpph_page.json.\n");
+		failures = 1;
+	} else {
+		failures = check_string(json, "next_collection_link", next);
+
+		json_object_object_get_ex(json, "total_size", &o_total_size);
+		failures += check_int("total_size",
+				      total_size,
+				      json_object_get_int(o_total_size));
+
+		json_object_object_get_ex(json, "entries", &o_entries);
+
+		failures += check_int("entries",
+				      entries.n,
+				      json_object_array_length(o_entries));
+
+		for (i = 0; i < entries.n && !failures; i++)
+			failures += check_bpph_entry
+				(json_object_array_get_idx(o_entries, i),
+				 &entries.entries[i]);
+	}
+
+	free(entries.entries);
+	free(buf);
+	json_object_put(json);
+	free(payload);
+
+	return failures;
+}
+
+static int test_daily_download_totals()
+{
+	char *payload, *buf;
+	json_object *json;
+	struct daily_download_total **ddts, **cur;
+	struct tm tm;
+	int failures;
+
+	payload = load_payload("daily_download_totals.json");
+	json = json_tokener_parse(payload);
+
+	buf = strdup(payload);
+	ddts = lp_parse_daily_download_totals(buf);
+
+	if (!ddts) {
+		fprintf(stderr,
+			"Failed to parse daily_download_totals.json.\n");
+		failures = 1;
+	} else {
+		failures = 0;
+		cur = ddts;
+
+		json_object_object_foreach(json, key, val) {
+			if (!*cur) {
+				fprintf(stderr, "Missing total for %s.\n", key);
+				failures++;
+				break;
+			}
+
+			memset(&tm, 0, sizeof(struct tm));
+			strptime(key, "%F", &tm);
+
+			failures += check_int("count",
+					      (*cur)->count,
+					      json_object_get_int(val));
+			failures += check_int("date",
+					      mktime(&(*cur)->date),
+					      mktime(&tm));
+			cur++;
+		}
+
+		failures += check_int("totals", !!*cur, 0);
+
+		daily_download_total_list_free(ddts);
+	}
+
+	free(buf);
+	json_object_put(json);
+	free(payload);
+
+	return failures;
+}
+
+static int test_distro_arch_series()
+{
+	char *payload, *buf;
+	json_object *json;
+	struct distro_arch_series *d;
+	int failures;
+
+	payload = load_payload("distro_arch_series.json");
+	json = json_tokener_parse(payload);
+
+	buf = strdup(payload);
+	d = lp_parse_distro_arch_series(buf);
+
+	if (!d) {
+		fprintf(stderr, "Failed to parse distro_arch_series.json.\n");
+		failures = 1;
+	} else {
+		failures = check_string(json, "display_name", d->display_name);
+		failures += check_string(json, "title", d->title);
+		failures += check_string(json,
+					 "architecture_tag",
+					 d->architecture_tag);
+		failures += check_string(json,
+					 "distroseries_link",
+					 d->distroseries_link);
+		failures += check_int("is_nominated_arch_indep",
+				      d->is_nominated_arch_indep,
+				      get_boolean(json,
+						  "is_nominated_arch_indep"));
+
+		distro_arch_series_free(d);
+	}
+
+	free(buf);
+	json_object_put(json);
+	free(payload);
+
+	return failures;
+}
+
+static int test_distro_series()
+{
+	char *payload, *buf;
+	json_object *json;
+	struct distro_series *d;
+	int failures;
+
+	payload = load_payload("distro_series.json");
+	json = json_tokener_parse(payload);
+
+	buf = strdup(payload);
+	d = lp_parse_distro_series(buf);
+
+	if (!d) {
+		fprintf(stderr, "Failed to parse distro_series.json.\n");
+		failures = 1;
+	} else {
+		failures = check_string(json, "displayname", d->displayname);
+		failures += check_string(json, "name", d->name);
+		failures += check_string(json, "version", d->version);
+		failures += check_string(json, "title", d->title);
+
+		distro_series_free(d);
+	}
+
+	free(buf);
+	json_object_put(json);
+	free(payload);
+
+	return failures;
+}
+
+static int test_ppa_names()
+{
+	char *payload, *buf, *next, **names;
+	json_object *json, *entries;
+	int failures, i, n;
+
+	payload = load_payload("ppas.json");
+	json = json_tokener_parse(payload);
+
+	buf = strdup(payload);
+	names = lp_parse_ppa_names(buf, &next);
+
+	if (!names) {
+		fprintf(stderr, "Failed to parse ppas.json.\n");
+		failures = 1;
+	} else {
+		failures = check_string(json, "next_collection_link", next);
+
+		json_object_object_get_ex(json, "entries", &entries);
+		n = json_object_array_length(entries);
+		failures += check_int("number of PPAs",
+				      list_length((void **)names),
+				      n);
+
+		for (i = 0; i < n && names[i]; i++) {
+			failures += check_string
+				(json_object_array_get_idx(entries, i),
+				 "name",
+				 names[i]);
+			free(names[i]);
+		}
+		for (; names[i]; i++)
+			free(names[i]);
+
+		vector_free((void **)names);
+	}
+
+	free(buf);
+	json_object_put(json);
+	free(payload);
+
+	return failures;
+}
+
+static int test_invalid()
+{
+	char buf[128];
+	char *next;
+	struct entries entries;
+	struct daily_download_total **ddts;
+	int failures;
+
+	failures = 0;
+	entries.entries = NULL;
+	entries.n = 0;
+
+	strcpy(buf, "{\"entries\": [{\"self_link\": \"a\"}, {\"self_li");
+	failures += check_int("truncated page",
+			      lp_parse_bpph_page(buf,
+						 add_entry,
+						 &entries,
+						 &next,
+						 NULL),
+			      -1);
+
+	strcpy(buf, "{\"2014-01-01\": 3, \"2014-01-02\" 4}");
+	ddts = lp_parse_daily_download_totals(buf);
+	failures += check_int("invalid totals", !!ddts, 0);
+
+	strcpy(buf, "{\"2014-01-01\": 3, \"total\": 4}");
+	ddts = lp_parse_daily_download_totals(buf);
+	failures += check_int("invalid day", !!ddts, 0);
+	daily_download_total_list_free(ddts);
+
+	strcpy(buf, "{\"name\": \"\\x\"}");
+	failures += check_int("invalid escape",
+			      !!lp_parse_distro_series(buf),
+			      0);
+
+	strcpy(buf, "{\"name\": \"a\", \"version\": \"1\", "
+	       "\"title\": \"A\", \"displayname\": null}");
+	failures += check_int("null displayname",
+			      !!lp_parse_distro_series(buf),
+			      0);
+
+	strcpy(buf, "{\"display_name\": \"a\", \"title\": \"A\"}");
+	failures += check_int("missing architecture_tag",
+			      !!lp_parse_distro_arch_series(buf),
+			      0);
+
+	free(entries.entries);
+
+	return failures;
+}
+
+static void json_c_parse_bpph_page(const char *payload)
+{
+	json_object *json, *o_entries, *o;
+	int i, n;
+
+	json = json_tokener_parse(payload);
+
+	json_object_object_get_ex(json, "entries", &o_entries);
+	n = json_object_array_length(o_entries);
+
+	for (i = 0; i < n; i++) {
+		o = json_object_array_get_idx(o_entries, i);
+
+		get_string(o, "binary_package_name");
+		get_string(o, "binary_package_version");
+		get_string(o, "distro_arch_series_link");
+		get_string(o, "self_link");
+		get_string(o, "status");
+		get_boolean(o, "architecture_specific");
+		str_to_time(get_string(o, "date_created"));
+	}
+
+	get_string(json, "next_collection_link");
+
+	json_object_put(json);
+}
+
+static void ignore_entry(const struct bpph_entry *e, void *data)
+{
+}
+
+static void lp_parse_bpph_page_only(char *json)
+{
+	char *next;
+
+	lp_parse_bpph_page(json, ignore_entry, NULL, &next, NULL);
+}
+
+static void json_c_parse_ddts(const char *payload)
+{
+	json_object *json;
+	struct tm tm;
+
+	json = json_tokener_parse(payload);
+
+	json_object_object_foreach(json, key, val) {
+		memset(&tm, 0, sizeof(struct tm));
+		strptime(key, "%FT%T%z", &tm);
+		json_object_get_int(val);
+	}
+
+	json_object_put(json);
+}
+
+static void lp_parse_ddts(char *json)
+{
+	daily_download_total_list_free(lp_parse_daily_download_totals(json));
+}
+
+static void json_c_parse_distro_arch_series(const char *payload)
+{
+	json_object *json;
+
+	json = json_tokener_parse(payload);
+
+	get_string(json, "display_name");
+	get_string(json, "title");
+	get_string(json, "architecture_tag");
+	get_string(json, "distroseries_link");
+	get_boolean(json, "is_nominated_arch_indep");
+
+	json_object_put(json);
+}
+
+static void lp_parse_das(char *json)
+{
+	distro_arch_series_free(lp_parse_distro_arch_series(json));
+}
+
+static void json_c_parse_distro_series(const char *payload)
+{
+	json_object *json;
+
+	json = json_tokener_parse(payload);
+
+	get_string(json, "displayname");
+	get_string(json, "name");
+	get_string(json, "version");
+	get_string(json, "title");
+
+	json_object_put(json);
+}
+
+static void lp_parse_ds(char *json)
+{
+	distro_series_free(lp_parse_distro_series(json));
+}
+
+static void bench_payload(const char *name,
+			  void (*json_c_parse)(const char *payload),
+			  void (*lp_parse)(char *json))
+{
+	char *payload;
+
+	payload = load_payload(name);
+
+	bench(name, payload, json_c_parse, lp_parse);
+
+	free(payload);
+}
+
+int main(int argc, char **argv)
+{
+	int failures;
+
+	/* the times are compared to the mktime() ones, in UTC */
+	setenv("TZ", "UTC", 1);
+	tzset();
+
+	failures = 0;
+
+	failures += test_bpph_page();
+	failures += test_daily_download_totals();
+	failures += test_distro_arch_series();
+	failures += test_distro_series();
+	failures += test_ppa_names();
+	failures += test_invalid();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+
+	bench_payload("bpph_page.json",
+		      json_c_parse_bpph_page,
+		      lp_parse_bpph_page_only);
+	bench_payload("daily_download_totals.json",
+		      json_c_parse_ddts,
+		      lp_parse_ddts);
+	bench_payload("distro_arch_series.json",
+		      json_c_parse_distro_arch_series,
+		      lp_parse_das);
+	bench_payload("distro_series.json",
+		      json_c_parse_distro_series,
+		      lp_parse_ds);
+
+	exit(EXIT_SUCCESS);
+}
@@ -92,6 +92,261 @@ static int tests_time_to_ISO8601_date()
 	return failures;
 }
 
+static int test_ISO8601_time_to_time(const char *str, int ret, time_t ref)
+{
+	time_t t;
+	int result;
+
+	t = 0;
+	result = ISO8601_time_to_time(str, &t);
+
+	if (result != ret || (!ret && t != ref)) {
+		fprintf(stderr,
+			"test_ISO8601_time_to_time(%s)=%d,%ld "
+			"instead of %d,%ld.\n",
+			str,
+			result,
+			t,
+			ret,
+			ref);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int tests_ISO8601_time_to_time()
+{
+	int failures;
+
+	failures = 0;
+
+	failures += test_ISO8601_time_to_time("1970-01-01T00:00:00", 0, 0);
+	failures += test_ISO8601_time_to_time("1970-01-01T00:01:23", 0, 83);
+	failures += test_ISO8601_time_to_time("2014-02-16T09:18:41",
+					      0,
+					      1392542321);
+	failures += test_ISO8601_time_to_time("2014-02-16T09:18:41Z",
+					      0,
+					      1392542321);
+	failures += test_ISO8601_time_to_time
+		("2014-02-16T09:18:41.383245+00:00", 0, 1392542321);
+	failures += test_ISO8601_time_to_time
+		("2014-02-16T11:18:41.3+02:00", 0, 1392542321);
+	failures += test_ISO8601_time_to_time("2014-02-16T04:18:41-0500",
+					      0,
+					      1392542321);
+	failures += test_ISO8601_time_to_time("2012-02-29T23:59:59",
+					      0,
+					      1330559999);
+	failures += test_ISO8601_time_to_time("1969-12-31T23:59:59", 0, -1);
+
+	failures += test_ISO8601_time_to_time("", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-02-16", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-02-16 09:18:41", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-13-16T09:18:41", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-02-16T24:18:41", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-02-16T09:18", -1, 0);
+	failures += test_ISO8601_time_to_time("2014-2-16T09:18:41", -1, 0);
+
+	return failures;
+}
+
+static int
+test_ISO8601_date_to_tm(const char *str, int ret, int y, int m, int d)
+{
+	struct tm tm;
+	int result;
+
+	memset(&tm, 0, sizeof(struct tm));
+	result = ISO8601_date_to_tm(str, &tm);
+
+	if (result != ret
+	    || (!ret && (tm.tm_year != y - 1900
+			 || tm.tm_mon != m - 1
+			 || tm.tm_mday != d))) {
+		fprintf(stderr,
+			"test_ISO8601_date_to_tm(%s)=%d,%d-%d-%d.\n",
+			str,
+			result,
+			tm.tm_year + 1900,
+			tm.tm_mon + 1,
+			tm.tm_mday);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int tests_ISO8601_date_to_tm()
+{
+	int failures;
+
+	failures = 0;
+
+	failures += test_ISO8601_date_to_tm("2014-02-16", 0, 2014, 2, 16);
+	failures += test_ISO8601_date_to_tm("1970-01-01", 0, 1970, 1, 1);
+	failures += test_ISO8601_date_to_tm("2014-12-31T00:00:00",
+					    0,
+					    2014, 12, 31);
+
+	failures += test_ISO8601_date_to_tm("2014-00-16", -1, 0, 0, 0);
+	failures += test_ISO8601_date_to_tm("2014-02-32", -1, 0, 0, 0);
+	failures += test_ISO8601_date_to_tm("2014/02/16", -1, 0, 0, 0);
+	failures += test_ISO8601_date_to_tm("2014-02", -1, 0, 0, 0);
+
+	return failures;
+}
+
+static int tests_days()
+{
+	int failures, y, m, d;
+	long days;
+
+	failures = 0;
+
+	if (date_to_days(1970, 1, 1) != 0
+	    || date_to_days(1969, 12, 31) != -1
+	    || date_to_days(2000, 3, 1) != 11017
+	    || date_to_days(2014, 2, 16) != 16117) {
+		fprintf(stderr, "date_to_days failure.\n");
+		failures++;
+	}
+
+	for (days = -800000; days <= 800000; days += 7) {
+		days_to_date(days, &y, &m, &d);
+
+		if (date_to_days(y, m, d) != days) {
+			fprintf(stderr,
+				"days_to_date(%ld)=%d-%d-%d.\n",
+				days, y, m, d);
+			failures++;
+			break;
+		}
+	}
+
+	return failures;
+}
+
+static int tests_utc_time()
+{
+	struct tm tm, ref;
+	time_t t;
+	int failures;
+
+	failures = 0;
+
+	for (t = -2000000000L; t < 4000000000L; t += 86399 * 13 + 7) {
+		gmtime_r(&t, &ref);
+		utc_time_to_tm(t, &tm);
+
+		if (tm.tm_year != ref.tm_year
+		    || tm.tm_mon != ref.tm_mon
+		    || tm.tm_mday != ref.tm_mday
+		    || tm.tm_hour != ref.tm_hour
+		    || tm.tm_min != ref.tm_min
+		    || tm.tm_sec != ref.tm_sec
+		    || tm.tm_wday != ref.tm_wday
+		    || tm.tm_yday != ref.tm_yday) {
+			fprintf(stderr, "utc_time_to_tm(%ld) failure.\n", t);
+			failures++;
+			break;
+		}
+
+		if (tm_to_utc_time(&ref) != t) {
+			fprintf(stderr, "tm_to_utc_time(%ld) failure.\n", t);
+			failures++;
+			break;
+		}
+	}
+
+	/* out of range fields are normalized */
+	memset(&tm, 0, sizeof(struct tm));
+	tm.tm_year = 114;
+	tm.tm_mon = 13;
+	tm.tm_mday = 0;
+	if (tm_to_utc_time(&tm) != 1422662400) { /* 2015-01-31 */
+		fprintf(stderr, "tm_to_utc_time normalization failure.\n");
+		failures++;
+	}
+
+	return failures;
+}
+
+static int test_time_to_ISO8601_r(time_t t, const char *time_ref)
+{
+	char time_buf[ISO8601_TIME_SIZE], date_buf[ISO8601_DATE_SIZE];
+	struct tm tm;
+	int failures;
+
+	failures = 0;
+
+	utc_time_to_tm(t, &tm);
+
+	if (time_to_ISO8601_time_r(t, time_buf) != time_buf
+	    || strcmp(time_buf, time_ref)
+	    || tm_to_ISO8601_time_r(&tm, time_buf) != time_buf
+	    || strcmp(time_buf, time_ref)) {
+		fprintf(stderr,
+			"time_to_ISO8601_time_r(%ld)=%s instead of %s.\n",
+			t,
+			time_buf,
+			time_ref);
+		failures++;
+	}
+
+	if (time_to_ISO8601_date_r(t, date_buf) != date_buf
+	    || strncmp(date_buf, time_ref, ISO8601_DATE_SIZE - 1)
+	    || tm_to_ISO8601_date_r(&tm, date_buf) != date_buf
+	    || strlen(date_buf) != ISO8601_DATE_SIZE - 1) {
+		fprintf(stderr,
+			"time_to_ISO8601_date_r(%ld)=%s.\n",
+			t,
+			date_buf);
+		failures++;
+	}
+
+	return failures;
+}
+
+static int tests_ISO8601_r()
+{
+	char buf[ISO8601_TIME_SIZE];
+	struct tm tm;
+	time_t t, t2;
+	int failures;
+
+	failures = 0;
+
+	failures += test_time_to_ISO8601_r(0, "1970-01-01T00:00:00");
+	failures += test_time_to_ISO8601_r(83, "1970-01-01T00:01:23");
+	failures += test_time_to_ISO8601_r(1392542321, "2014-02-16T09:18:41");
+	failures += test_time_to_ISO8601_r(-1, "1969-12-31T23:59:59");
+	failures += test_time_to_ISO8601_r(253402300799,
+					   "9999-12-31T23:59:59");
+
+	/* years which are not 4 digits long */
+	memset(&tm, 0, sizeof(struct tm));
+	tm.tm_year = 10000 - 1900;
+	tm.tm_mday = 1;
+	if (tm_to_ISO8601_time_r(&tm, buf) || tm_to_ISO8601_date_r(&tm, buf)) {
+		fprintf(stderr, "tm_to_ISO8601_r(10000) failure.\n");
+		failures++;
+	}
+
+	/* the cached current time follows time() */
+	t = time(NULL);
+	if (!get_current_ISO8601_time_r(buf)
+	    || ISO8601_time_to_time(buf, &t2)
+	    || t2 < t
+	    || t2 > time(NULL)) {
+		fprintf(stderr, "get_current_ISO8601_time_r()=%s.\n", buf);
+		failures++;
+	}
+
+	return failures;
+}
+
 int main(int argc, char **argv)
 {
 	int failures;
@@ -100,6 +355,11 @@ int main(int argc, char **argv)
 
 	failures += tests_time_to_ISO8601_time();
 	failures += tests_time_to_ISO8601_date();
+	failures += tests_ISO8601_time_to_time();
+	failures += tests_ISO8601_date_to_tm();
+	failures += tests_days();
+	failures += tests_utc_time();
+	failures += tests_ISO8601_r();
 
 	if (failures)
 		exit(EXIT_FAILURE);
@@ -0,0 +1,219 @@
+/*
+  Copyright (C) 2026 agent@local
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301 USA
+*/
+/*
+ * Checks the range sums of the prefix sums of daily download totals
+ * against the sums of the totals themselves.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ptime.h>
+#include <series.h>
+
+static struct daily_download_total *ddt_new(const char *date, int count)
+{
+	struct daily_download_total *ddt;
+
+	ddt = malloc(sizeof(struct daily_download_total));
+	memset(ddt, 0, sizeof(struct daily_download_total));
+	ISO8601_date_to_tm(date, &ddt->date);
+	ddt->count = count;
+
+	return ddt;
+}
+
+static long get_day(const char *date)
+{
+	long day;
+
+	if (series_parse_day(date, &day)) {
+		fprintf(stderr, "series_parse_day(%s) failure.\n", date);
+		exit(EXIT_FAILURE);
+	}
+
+	return day;
+}
+
+static int test_sum(const struct series *s,
+		    const char *from,
+		    const char *to,
+		    long ref)
+{
+	long sum;
+
+	sum = series_sum(s,
+			 from ? get_day(from) : LONG_MIN,
+			 to ? get_day(to) : LONG_MAX);
+
+	if (sum != ref) {
+		fprintf(stderr,
+			"series_sum(%s, %s)=%ld instead of %ld.\n",
+			from,
+			to,
+			sum,
+			ref);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int tests_windows(const struct series *s)
+{
+	/* totals of the days from 2014-02-25 to 2014-03-05 */
+	static const long days[] = { 16, 0, 1, 2, 0, 4, 0, 0, 8 };
+	long sums[12], from, ref;
+	int failures, i, j;
+
+	failures = 0;
+
+	/* the period before 2014-02-27..28 is 2014-02-25..26 */
+	from = get_day("2014-02-27");
+	if (series_sum_previous(s, from, from + 1) != 16
+	    || series_sum_previous(s, from + 2, from + 5) != 19
+	    || series_sum_previous(s, from - 2, from - 1) != 0) {
+		fprintf(stderr, "series_sum_previous() failure.\n");
+		failures++;
+	}
+
+	/* 3 days windows from 2014-02-24 to 2014-03-07 */
+	from = get_day("2014-02-24");
+	series_rolling_sums(s, from, from + 11, 3, sums);
+
+	for (i = 0; i < 12; i++) {
+		ref = 0;
+		for (j = i - 3; j < i; j++)
+			if (j >= 0 && j < 9)
+				ref += days[j];
+
+		if (sums[i] != ref) {
+			fprintf(stderr,
+				"series_rolling_sums()[%d]=%ld, not %ld.\n",
+				i,
+				sums[i],
+				ref);
+			failures++;
+		}
+	}
+
+	return failures;
+}
+
+static int tests_series()
+{
+	struct daily_download_total *ddts[6];
+	struct series *s;
+	int failures, i;
+
+	failures = 0;
+
+	/* unsorted, with missing days and a month change */
+	ddts[0] = ddt_new("2014-03-02", 4);
+	ddts[1] = ddt_new("2014-02-27", 1);
+	ddts[2] = ddt_new("2014-02-28", 2);
+	ddts[3] = ddt_new("2014-03-05", 8);
+	ddts[4] = ddt_new("2014-02-25", 16);
+	ddts[5] = NULL;
+
+	s = series_new(ddts);
+
+	if (s->first_day != get_day("2014-02-25") || s->n_days != 9) {
+		fprintf(stderr, "series_new() range failure.\n");
+		failures++;
+	}
+
+	failures += test_sum(s, NULL, NULL, 31);
+	failures += test_sum(s, "2014-02-25", "2014-03-05", 31);
+	failures += test_sum(s, "2014-02-27", "2014-03-02", 7);
+	failures += test_sum(s, "2014-02-28", "2014-02-28", 2);
+	failures += test_sum(s, "2014-03-01", "2014-03-01", 0);
+	failures += test_sum(s, "2014-03-01", NULL, 12);
+	failures += test_sum(s, NULL, "2014-02-27", 17);
+	failures += test_sum(s, "2010-01-01", "2014-02-26", 16);
+	failures += test_sum(s, "2014-03-06", "2020-01-01", 0);
+	failures += test_sum(s, "2014-03-02", "2014-02-27", 0);
+
+	failures += tests_windows(s);
+
+	series_free(s);
+	for (i = 0; ddts[i]; i++)
+		free(ddts[i]);
+
+	/* no totals */
+	s = series_new(ddts + 5);
+	failures += test_sum(s, NULL, NULL, 0);
+	failures += test_sum(s, "2014-02-25", "2014-03-05", 0);
+	series_free(s);
+
+	s = series_new(NULL);
+	failures += test_sum(s, NULL, NULL, 0);
+	series_free(s);
+
+	return failures;
+}
+
+static int test_parse_day(const char *str, int ret)
+{
+	long day;
+
+	if (series_parse_day(str, &day) != ret) {
+		fprintf(stderr, "series_parse_day(%s) failure.\n", str);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int tests_parse_day()
+{
+	int failures;
+
+	failures = 0;
+
+	failures += test_parse_day("2014-02-16", 0);
+	failures += test_parse_day("2014-02-16T09:18:41", -1);
+	failures += test_parse_day("2014-02-30", -1);
+	failures += test_parse_day("2014-2-16", -1);
+	failures += test_parse_day("", -1);
+
+	if (get_day("1970-01-01") != 0 || get_day("2014-02-16") != 16117) {
+		fprintf(stderr, "series_parse_day() day failure.\n");
+		failures++;
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	int failures;
+
+	failures = 0;
+
+	failures += tests_series();
+	failures += tests_parse_day();
+
+	if (failures)
+		exit(EXIT_FAILURE);
+	else
+		exit(EXIT_SUCCESS);
+}
@@ -158,3 +158,18 @@ function ppastats_ppa() {
 	});
     });
 }
+
+function ppastats_owner() {
+    $(document).ready(function() {
+	$.getJSON("index.json", function(data) {
+	    $("#owner_name").html(data["owner"]);
+
+	    $.each(data["ppas"], function(i, item) {
+		var url = item["name"]+"/index.html";
+		$("#ppas").append("<li><a href='"+url+"'>"+item["name"]+"</a>: "+item["count"]+"</li>");
+	    });
+
+	    ppastats_chart(data["ddts"]);
+	});
+    });
+}
@@ -0,0 +1,16 @@
+<div id="menu">
+  <div class="pkgs">
+    <div>
+      <em>Owner</em>: <span id="owner_name">N/A</span>
+    </div>
+
+    <div>
+      <em>PPAs</em>:
+      <ul id="ppas"></ul>
+    </div>
+  </div>
+</div>
+
+<div id="main">
+  <div id="chart"></div>
+</div>